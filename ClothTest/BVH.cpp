@@ -1,9 +1,9 @@
 #pragma once
 #include "BVH.h"
 #include <cmath>
-#include <glad/glad.h>
 #include "Point.h"
 #include "Sphere.h"
+#include "DebugDrawBatch.h"
 
 struct ConstructNode
 {
@@ -195,6 +195,10 @@ void BVH::recursiveFindPoints(const size_t a_nodeToSearch, const Sphere& a_spher
 void BVH::recursiveUpdateNodes(const size_t a_nodeToSearch)
 {
 	auto& node = m_nodes[a_nodeToSearch];
+	if (!node.m_active)
+	{
+		return;
+	}
 
 	//non-leaf nodes update their child boxes and then their own boxes based on the result
 	if (!node.m_payload)
@@ -259,10 +263,22 @@ void BVH::update()
 	recursiveUpdateNodes(0);
 }
 
+void BVH::propagateActive()
+{
+	//children are always stored after their parent, so walking backwards settles them first
+	for (size_t k = m_nodes.size(); k-- > 0;)
+	{
+		auto& node = m_nodes[k];
+		if (!node.m_payload)
+		{
+			node.m_active = (node.m_children[0] != 0 && m_nodes[node.m_children[0]].m_active) || (node.m_children[1] != 0 && m_nodes[node.m_children[1]].m_active);
+		}
+	}
+}
+
 void BVH::draw(const Camera& a_camera, bool a_persistent)const
 {
-	std::vector<float> data;
-	data.reserve(m_nodes.size() * 12 * 6);
+	DebugDrawBatch& batch = getDebugBatch();
 	for (const auto& node : m_nodes)
 	{
 		std::pair<glm::vec3, glm::ivec3> points[8]{
@@ -276,50 +292,34 @@ void BVH::draw(const Camera& a_camera, bool a_persistent)const
 			{ node.m_box.m_max, { 1, 1, 1 } }
 		};
 
+		//corners that share two of their signs form an edge; every pair is visited once
 		for (int k = 0; k < 8; k++)
 		{
-			for (int i = 0; i < 8; i++)
+			for (int i = k + 1; i < 8; i++)
 			{
-				std::pair<glm::vec3, glm::ivec3>* currentPoints[2] { &points[k], &points[i] };
 				int totalInCommon = 0;
 				for (int axis = 0; axis < 3; axis++)
 				{
-					if (currentPoints[0]->second[axis] == currentPoints[1]->second[axis])
+					if (points[k].second[axis] == points[i].second[axis])
 					{
 						totalInCommon++;
 					}
 				}
 				if (totalInCommon == 2)
 				{
-					for (size_t point = 0; point < 2; point++)
-					{
-						for (size_t axis = 0; axis < 3; axis++)
-						{
-							data.push_back(currentPoints[point]->first[axis]);
-						}
-						data.push_back(1.f);
-						data.push_back(0.f);
-						data.push_back(1.f);
-					}
+					batch.addLine(points[k].first, points[i].first, glm::vec3(1.f, 0.f, 1.f));
 				}
 			}
 		}
 	
 	}
-	if (a_persistent)
-	{
-		glDisable(GL_DEPTH_TEST);
-	}
-	drawData(a_camera, GL_LINES, sizeof(float) * data.size(), data.data(), data.size() / 6);
-	if (a_persistent)
-	{
-		glEnable(GL_DEPTH_TEST);
-	}
+	batch.flush(a_camera, a_persistent);
 }
 
 BVH::Node::Node(const BoundingBox& a_box)
 	: m_box(a_box)
 	, m_payload(nullptr)
+	, m_active(true)
 {}
 
 BVH::Node::~Node()
@@ -16,6 +16,17 @@ public:
 	~BVH();
 
 	void update();
+	//limits update to the subtrees holding a payload the predicate accepts; the other subtrees keep their boxes
+	//the selection holds for every following update, so it only needs to be set again when it changes
+	template<typename Predicate>
+	void setActivePayloads(Predicate&& a_isActive)
+	{
+		for (auto& node : m_nodes)
+		{
+			node.m_active = node.m_payload && a_isActive(static_cast<const Point*>(node.m_payload));
+		}
+		propagateActive();
+	}
 	void draw(const Camera& a_camera, bool a_persistent)const;
 
 	std::vector<Point*> getPayloadsWithinBox(const BoundingBox& a_box);
@@ -28,6 +39,8 @@ private:
 		BoundingBox m_box;
 		std::array<size_t, 2> m_children{ 0, 0 }; //both are zero if root, since root itself is zero
 		Point* m_payload;
+		//whether update refits this subtree
+		bool m_active;
 
 		Node(const BoundingBox& a_box);
 		~Node();
@@ -41,4 +54,6 @@ private:
 	void recursiveFindPoints(const size_t a_nodeToSearch, const BoundingBox& a_box, std::vector<Point*>& a_target);
 	void recursiveFindPoints(const size_t a_nodeToSearch, const Sphere& a_sphere, std::vector<Point*>& a_target);
 	void recursiveUpdateNodes(const size_t a_nodeToSearch);
+	//marks every inner node with an active child as active
+	void propagateActive();
 };
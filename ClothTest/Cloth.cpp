@@ -1,11 +1,19 @@
 #include "Cloth.h"
 #include <vector>
 #include <array>
+#include <cmath>
+#include <chrono>
+#include <cfloat>
+#include <cstring>
+#include <glm/common.hpp>
+#include <glm/ext/scalar_int_sized.hpp>
+#include <glm/ext/scalar_uint_sized.hpp>
 #include <glm/geometric.hpp>
 #include <glm/gtx/normal.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <glm/ext/matrix_clip_space.hpp>
 #include <glad/glad.h>
+#include "GLState.h"
 #include "Camera.h"
 
 #include "Point.h"
@@ -13,6 +21,15 @@
 #include "Sphere.h"
 #include "BVH.h"
 #include "Basis.h"
+#include "ClothSolver.h"
+#include "ProjectiveDynamics.h"
+#include "ImplicitIntegrator.h"
+#include "HierarchicalSolver.h"
+#include "Tethers.h"
+#include "SleepTracker.h"
+#include "TiledSolver.h"
+#include "StreamingBuffer.h"
+#include "DebugDrawBatch.h"
 
 #include "Shader.h"
 #include "VertexLayout.h"
@@ -22,21 +39,110 @@
 #include "KeyboardKey.h"
 
 Shader* Cloth::s_shader = nullptr;
-VertexLayout* Cloth::s_vertexLayout = nullptr;
+Shader* Cloth::s_gridShader = nullptr;
+
+//handles of the uniforms the cloth shaders set on every draw
+struct ClothUniforms
+{
+    Shader::Uniform m_positionOffset;
+    Shader::Uniform m_positionScale;
+    Shader::Uniform m_octahedralNormals;
+    Shader::Uniform m_gridSize;
+    Shader::Uniform m_firstTexel;
+};
+static ClothUniforms s_uniforms;
+VertexLayout* Cloth::s_vertexLayouts[Cloth::VERTEX_FORMAT_COUNT] = {};
 Texture* Cloth::s_cellShadingTexture = nullptr;
 
+//maps a unit vector onto an octahedron unfolded into the [-1, 1] square
+static glm::vec2 encodeOctahedral(const glm::vec3& a_normal)
+{
+    const glm::vec3 projected = a_normal / (std::abs(a_normal.x) + std::abs(a_normal.y) + std::abs(a_normal.z));
+    if (projected.z >= 0.f)
+    {
+        return glm::vec2(projected.x, projected.y);
+    }
+    //the lower half is folded over the diagonals
+    return glm::vec2(
+        (1.f - std::abs(projected.y)) * (projected.x >= 0.f ? 1.f : -1.f),
+        (1.f - std::abs(projected.x)) * (projected.y >= 0.f ? 1.f : -1.f)
+    );
+}
+
+//quantizes a value in [0, 1] to 16 bits, rounding to the nearest step
+static glm::uint16 quantizeUnorm16(float a_value)
+{
+    return static_cast<glm::uint16>(a_value * 65535.f + 0.5f);
+}
+
+//quantizes a value in [-1, 1] to a signed integer with the given maximum, rounding half away from zero
+static int quantizeSnorm(float a_value, float a_maximum)
+{
+    return static_cast<int>(a_value * a_maximum + (a_value >= 0.f ? 0.5f : -0.5f));
+}
+
+//whether a stage within the iterations reports the residual the adaptive iterations stop on
+static bool measuresResidual(const Cloth::SolverPipeline& a_pipeline)
+{
+    for (auto& stage : a_pipeline)
+    {
+        if (stage.m_stage == Cloth::SolverStage::Constraints && stage.m_iterationInterval > 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos, const Basis& a_basis, const float a_particleDistance, const float a_particleMass, const float a_maxParticleStretch)
     : GRID_SIZE(a_gridSize)
     , m_points(nullptr)
     , m_constraints(nullptr)
     , m_bvh(nullptr)
+    , m_projectiveDynamics(nullptr)
+    , m_implicitIntegrator(nullptr)
+    , m_hierarchicalSolver(nullptr)
+    , m_tethers(nullptr)
+    , m_sleepTracker(nullptr)
+    , m_sleepRevision(0)
+    , m_tiledSolver(nullptr)
     , m_timer(0)
     , m_restingDistance(a_particleDistance)
     , m_maxDistance(a_particleDistance + a_maxParticleStretch)
     , m_sqrRestingDistance(a_particleDistance * a_particleDistance)
-    , m_buffer(0)
+    , m_solverType(SolverType::Relaxation)
+    , m_timestep(FIXED_TIMESTEP)
+    , m_adaptiveMinSubstep(0.f)
+    , m_adaptiveMaxSubstep(0.f)
+    , m_substepCount(1)
+    , m_configuredTimestep(FIXED_TIMESTEP)
+    , m_configuredSubstepCount(1)
+    , m_iterationCount(NUM_ITERATIONS)
+    , m_substepDamping(Point::DEFAULT_DAMPING)
+    , m_adaptiveTolerance(0.f)
+    , m_maxAdaptiveIterations(NUM_ITERATIONS)
+    , m_lastIterationCount(0)
+    , m_stretchStiffness(100000.f)
+    , m_tileIterations(0)
+    , m_specializedStep(nullptr)
+    , m_pipeline(getDefaultPipeline())
+    , m_defaultPipeline(true)
+    , m_frameBudget(0.f)
+    , m_degradeTier(false)
+    , m_tierSelected(false)
+    , m_requestedTier(QualityTier::Medium)
+    , m_qualityTier(QualityTier::Medium)
+    , m_updatesWithinBudget(0)
+    , m_stepTimeBeforeDegrade(0.f)
+    , m_degradeIneffective(false)
+    , m_interpolateRendering(false)
+    , m_vertexFormat(VertexFormat::Float)
+    , m_vertexStream(nullptr)
+    , m_positionTexture(0)
     , m_indexBuffer(0)
     , m_initialRenderTarget({ 64, 64 })
+    , m_pinRevision(0)
+    , m_pinnedSetRevision(0)
 {
     const size_t DIM_X = GRID_SIZE.x;
     const size_t DIM_Y = GRID_SIZE.y;
@@ -93,6 +199,9 @@ Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos
     }
 
     printf("Point count: %zu; Constraint count: %zu\n", m_pointCount, m_constraintCount);
+    updatePinnedPoints();
+
+    setQualityTier(QualityTier::Medium);
 
     std::vector<Point*> pointVec;
     pointVec.reserve(m_pointCount);
@@ -106,11 +215,12 @@ Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos
     {
         createRenderingResources();
     }
-    glGenBuffers(1, &m_buffer);
+    m_vertexStream = new StreamingBuffer(m_pointCount * getVertexSize(m_vertexFormat));
     glGenBuffers(1, &m_indexBuffer);
 
-    m_vertices = new VertexNode[m_pointCount];
+    //two triangles per grid cell; the normals come straight from the grid, so the triangles are only kept in the index buffer
     std::vector<unsigned int> indices;
+    indices.reserve(getIndexCount());
 
     size_t current = 0;
     for (size_t x = 0; x < GRID_SIZE.x; x++)
@@ -124,15 +234,9 @@ Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos
                 size_t upNeighbour = current - 1;
 
                 std::array<size_t, 3> thisTriangle{ leftNeighbour, upNeighbour, current };
-
-                m_triangles.emplace_back();
-                auto& triangle = m_triangles.back();
                 for (size_t newVert = 0; newVert < 3; newVert++)
                 {
-                    size_t addedVertIndex = thisTriangle[newVert];
-                    indices.push_back(addedVertIndex);
-                    triangle.vertices[newVert] = addedVertIndex;
-                    m_vertices[addedVertIndex].triangles.push_back(m_triangles.size() - 1);
+                    indices.push_back(thisTriangle[newVert]);
                 }
             }
 
@@ -142,15 +246,9 @@ Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos
                 size_t downNeighbour = current + 1;
 
                 std::array<size_t, 3> thisTriangle{ rightNeighbour, downNeighbour, current };
-
-                m_triangles.emplace_back();
-                auto& triangle = m_triangles.back();
                 for (size_t newVert = 0; newVert < 3; newVert++)
                 {
-                    size_t addedVertIndex = thisTriangle[newVert];
-                    indices.push_back(addedVertIndex);
-                    triangle.vertices[newVert] = addedVertIndex;
-                    m_vertices[addedVertIndex].triangles.push_back(m_triangles.size() - 1);
+                    indices.push_back(thisTriangle[newVert]);
                 }
 
             }
@@ -159,20 +257,34 @@ Cloth::Cloth(const glm::vec<2, size_t>& a_gridSize, const glm::vec3& a_centerPos
         }
     }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    VertexLayout::unbind();
+    GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(unsigned int) * indices.size(), indices.data(), GL_STATIC_DRAW);
 }
 
 Cloth::~Cloth()
 {
-    if (m_buffer)
+    if (m_positionTexture)
     {
-        glDeleteBuffers(1, &m_buffer);
+        GLState::deleteTexture(m_positionTexture);
     }
-    delete[] m_vertices;
-    m_vertices = nullptr;
+    s_vertexLayouts[static_cast<size_t>(m_vertexFormat)]->releaseVertexArrays(m_vertexStream->getBuffer());
+    delete m_vertexStream;
+    m_vertexStream = nullptr;
     delete m_bvh;
     m_bvh = nullptr;
+    delete m_projectiveDynamics;
+    m_projectiveDynamics = nullptr;
+    delete m_implicitIntegrator;
+    m_implicitIntegrator = nullptr;
+    delete m_hierarchicalSolver;
+    m_hierarchicalSolver = nullptr;
+    delete m_tethers;
+    m_tethers = nullptr;
+    delete m_sleepTracker;
+    m_sleepTracker = nullptr;
+    delete m_tiledSolver;
+    m_tiledSolver = nullptr;
 }
 
 Point& Cloth::getPointAt(size_t a_x, size_t a_y)
@@ -187,77 +299,776 @@ const Point& Cloth::getPointAt(size_t a_x, size_t a_y)const
 
 void Cloth::update(float a_deltaTime)
 {
+    const auto updateStart = std::chrono::steady_clock::now();
     m_timer += a_deltaTime;
-    while (m_timer >= FIXED_TIMESTEP)
+    if (m_frameBudget > 0.f)
     {
-        m_timer -= FIXED_TIMESTEP;
-        for (size_t k = 0; k < m_pointCount; k++)
+        //a backlog that keeps growing is dropped instead of being caught up, which would make the next frame even slower
+        m_timer = std::min(m_timer, m_timestep * static_cast<float>(MAX_CARRIED_STEPS + 1));
+    }
+
+    if (m_adaptiveMaxSubstep > 0.f)
+    {
+        const float substep = selectAdaptiveSubstep();
+        if (substep != m_timestep || m_substepCount != 1)
+        {
+            setStepLength(substep, 1);
+        }
+    }
+
+    //the kinematic targets are spread over every substep this update runs
+    size_t timestepCount = 0;
+    for (float timer = m_timer; timer >= m_timestep; timer -= m_timestep)
+    {
+        timestepCount++;
+    }
+    const size_t plannedSteps = timestepCount * m_substepCount;
+    size_t currentStep = 0;
+    bool overBudget = false;
+
+    while (m_timer >= m_timestep)
+    {
+        if (m_frameBudget > 0.f && currentStep > 0)
+        {
+            const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - updateStart;
+            if (elapsed.count() >= m_frameBudget)
+            {
+                overBudget = true;
+                break;
+            }
+        }
+
+        if (m_interpolateRendering)
+        {
+            for (size_t k = 0; k < m_pointCount; k++)
+            {
+                m_lastStepPositions[k] = m_points[k].getPos();
+            }
+        }
+
+        m_timer -= m_timestep;
+        const float substep = m_timestep / static_cast<float>(m_substepCount);
+        for (size_t k = 0; k < m_substepCount; k++)
+        {
+            currentStep++;
+            applyKinematicTargets(static_cast<float>(currentStep) / static_cast<float>(plannedSteps));
+            step(substep);
+        }
+    }
+
+    //without every planned step the points go straight to their targets, so the next update starts where the caller expects
+    if (currentStep < plannedSteps || currentStep == 0)
+    {
+        applyKinematicTargets(1.f);
+    }
+    m_kinematicGroups.clear();
+
+    if (m_frameBudget > 0.f && m_degradeTier && m_tierSelected)
+    {
+        const std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - updateStart;
+        //an update over budget runs fewer steps, so only the time per step shows whether a tier is faster
+        const float stepTime = currentStep > 0 ? elapsed.count() / static_cast<float>(currentStep) : 0.f;
+        adjustQualityTier(elapsed.count(), stepTime, overBudget || elapsed.count() > m_frameBudget);
+    }
+}
+
+void Cloth::setFrameBudget(float a_seconds, bool a_degradeTier)
+{
+    m_frameBudget = a_seconds;
+    m_degradeTier = a_degradeTier;
+    m_updatesWithinBudget = 0;
+    m_stepTimeBeforeDegrade = 0.f;
+    m_degradeIneffective = false;
+    if (m_tierSelected)
+    {
+        applyQualityTier(m_requestedTier);
+    }
+}
+
+void Cloth::setRenderInterpolation(bool a_enabled)
+{
+    m_interpolateRendering = a_enabled;
+    m_lastStepPositions.resize(m_pointCount);
+    for (size_t k = 0; k < m_pointCount; k++)
+    {
+        m_lastStepPositions[k] = m_points[k].getPos();
+    }
+}
+
+void Cloth::adjustQualityTier(float a_updateTime, float a_stepTime, bool a_overBudget)
+{
+    const int tier = static_cast<int>(m_qualityTier);
+    //the first update after lowering the tier decides whether it is kept; if the load is elsewhere, fewer iterations only cost quality
+    if (m_stepTimeBeforeDegrade > 0.f && a_stepTime > 0.f)
+    {
+        const float previousStepTime = m_stepTimeBeforeDegrade;
+        m_stepTimeBeforeDegrade = 0.f;
+        if (a_stepTime >= previousStepTime)
+        {
+            m_degradeIneffective = true;
+            m_updatesWithinBudget = 0;
+            applyQualityTier(static_cast<QualityTier>(tier + 1));
+            printf("Lowering the quality tier did not make the cloth faster, restored tier %d\n", tier + 1);
+            return;
+        }
+    }
+
+    if (a_overBudget && m_qualityTier != QualityTier::Low && !m_degradeIneffective && a_stepTime > 0.f)
+    {
+        m_updatesWithinBudget = 0;
+        m_stepTimeBeforeDegrade = a_stepTime;
+        applyQualityTier(static_cast<QualityTier>(tier - 1));
+        printf("Cloth over its frame budget, lowered quality tier to %d\n", tier - 1);
+        return;
+    }
+
+    //the higher tier has to fit, so only a clearly light load counts towards recovery
+    m_updatesWithinBudget = a_updateTime < m_frameBudget * 0.5f ? m_updatesWithinBudget + 1 : 0;
+    if (m_updatesWithinBudget >= TIER_RECOVERY_UPDATES && m_qualityTier != m_requestedTier)
+    {
+        m_updatesWithinBudget = 0;
+        applyQualityTier(static_cast<QualityTier>(tier + 1));
+        printf("Cloth back within its frame budget, raised quality tier to %d\n", tier + 1);
+    }
+}
+
+void Cloth::setKinematicTargets(const std::vector<Point*>& a_points, const std::vector<glm::vec3>& a_localPositions, const Transform& a_start, const Transform& a_end)
+{
+    KinematicGroup group{ {}, a_localPositions, a_start, a_end };
+    group.m_points.reserve(a_points.size());
+    for (auto& point : a_points)
+    {
+        group.m_points.push_back(static_cast<size_t>(point - m_points));
+    }
+    m_kinematicGroups.push_back(std::move(group));
+}
+
+void Cloth::setKinematicTarget(Point& a_point, const glm::vec3& a_start, const glm::vec3& a_end)
+{
+    const glm::quat identity(1.f, 0.f, 0.f, 0.f);
+    setKinematicTargets({ &a_point }, { glm::vec3(0.f) }, Transform(a_start, identity, glm::vec3(1.f)), Transform(a_end, identity, glm::vec3(1.f)));
+}
+
+void Cloth::applyKinematicTargets(float a_progress)
+{
+    for (auto& group : m_kinematicGroups)
+    {
+        const Transform current(
+            glm::mix(group.m_start.getPos(), group.m_end.getPos(), a_progress),
+            glm::slerp(group.m_start.getRotation(), group.m_end.getRotation(), a_progress),
+            glm::mix(group.m_start.getScale(), group.m_end.getScale(), a_progress)
+        );
+        for (size_t k = 0; k < group.m_points.size(); k++)
+        {
+            m_points[group.m_points[k]].setPos(current.toWorldPos(group.m_localPositions[k]));
+            if (m_sleepTracker && !m_sleepTracker->isPointAwake(group.m_points[k]))
+            {
+                m_sleepTracker->markMoved(group.m_points[k]);
+            }
+        }
+    }
+}
+
+void Cloth::setSolverType(SolverType a_type)
+{
+    m_solverType = a_type;
+    if (m_solverType == SolverType::ProjectiveDynamics && !m_projectiveDynamics)
+    {
+        m_projectiveDynamics = new ProjectiveDynamics(GRID_SIZE, m_points, m_pointCount, m_constraints, m_constraintCount);
+    }
+    if (m_solverType == SolverType::ImplicitEuler && !m_implicitIntegrator)
+    {
+        m_implicitIntegrator = new ImplicitIntegrator(m_points, m_pointCount, m_constraints, m_constraintCount);
+    }
+    if (m_solverType == SolverType::Hierarchical && !m_hierarchicalSolver)
+    {
+        m_hierarchicalSolver = new HierarchicalSolver(GRID_SIZE, m_points, m_maxDistance);
+        printf("Hierarchical solver uses %zu levels\n", m_hierarchicalSolver->getLevelCount());
+    }
+}
+
+void Cloth::setTimestep(float a_timestep)
+{
+    m_configuredTimestep = a_timestep;
+    if (m_adaptiveMaxSubstep <= 0.f)
+    {
+        setStepLength(m_configuredTimestep, m_configuredSubstepCount);
+    }
+}
+
+void Cloth::setAdaptiveSubstepping(float a_minSubstep, float a_maxSubstep)
+{
+    const bool wasAdaptive = m_adaptiveMaxSubstep > 0.f;
+    m_adaptiveMinSubstep = std::min(a_minSubstep, a_maxSubstep);
+    m_adaptiveMaxSubstep = a_maxSubstep;
+    if (wasAdaptive && m_adaptiveMaxSubstep <= 0.f)
+    {
+        setStepLength(m_configuredTimestep, m_configuredSubstepCount);
+    }
+}
+
+float Cloth::selectAdaptiveSubstep()const
+{
+    float maxSqrDisplacement = 0.f;
+    for (size_t k = 0; k < m_pointCount; k++)
+    {
+        const glm::vec3 displacement = m_points[k].getPos() - m_points[k].getPreviousPos();
+        maxSqrDisplacement = std::max(maxSqrDisplacement, glm::dot(displacement, displacement));
+    }
+    const float maxSpeed = sqrtf(maxSqrDisplacement) / (m_timestep / static_cast<float>(m_substepCount));
+
+    //points should neither skip past a constraint length nor tunnel through a collider
+    float limit = m_restingDistance;
+    for (auto& sphere : m_spheres)
+    {
+        limit = std::min(limit, sphere->getRadius());
+    }
+    limit *= ADAPTIVE_DISPLACEMENT_LIMIT;
+
+    //halving keeps the chosen lengths to a few values, so the velocity is rarely rescaled
+    float substep = m_adaptiveMaxSubstep;
+    while (substep * 0.5f >= m_adaptiveMinSubstep && maxSpeed * substep > limit)
+    {
+        substep *= 0.5f;
+    }
+    return substep;
+}
+
+void Cloth::setSubstepCount(size_t a_substeps)
+{
+    m_configuredSubstepCount = std::max<size_t>(a_substeps, 1);
+    if (m_adaptiveMaxSubstep <= 0.f)
+    {
+        setStepLength(m_configuredTimestep, m_configuredSubstepCount);
+    }
+}
+
+void Cloth::setStepLength(float a_timestep, size_t a_substeps)
+{
+    const float previousSubstep = m_timestep / static_cast<float>(m_substepCount);
+    const float substep = a_timestep / static_cast<float>(a_substeps);
+    //the previous positions hold the velocity per substep, so it is rescaled to the new substep length
+    const float velocityScale = substep / previousSubstep;
+    for (size_t k = 0; k < m_pointCount; k++)
+    {
+        m_points[k].scaleVelocity(velocityScale);
+    }
+    m_timestep = a_timestep;
+    m_substepCount = a_substeps;
+    //keeps the damping per second the same regardless of the step length
+    m_substepDamping = powf(Point::DEFAULT_DAMPING, substep / FIXED_TIMESTEP);
+}
+
+void Cloth::setIterationCount(size_t a_iterations)
+{
+    m_iterationCount = std::max<size_t>(a_iterations, 1);
+    m_specializedStep = nullptr;
+    m_tierSelected = false;
+}
+
+void Cloth::setQualityTier(QualityTier a_tier)
+{
+    m_tierSelected = true;
+    m_requestedTier = a_tier;
+    m_stepTimeBeforeDegrade = 0.f;
+    m_degradeIneffective = false;
+    applyQualityTier(a_tier);
+}
+
+void Cloth::applyQualityTier(QualityTier a_tier)
+{
+    m_qualityTier = a_tier;
+    m_iterationCount = getTierIterationCount(a_tier);
+    m_specializedStep = selectSolverStep(a_tier, GRID_SIZE);
+}
+
+void Cloth::setAdaptiveIterations(float a_tolerance, size_t a_maxIterations)
+{
+    if (a_tolerance > 0.f && !measuresResidual(m_pipeline))
+    {
+        printf("The solver pipeline never measures the residual, keeping the iteration count\n");
+        return;
+    }
+    m_adaptiveTolerance = a_tolerance;
+    m_maxAdaptiveIterations = std::max<size_t>(a_maxIterations, 1);
+}
+
+void Cloth::setSleepingEnabled(bool a_enabled)
+{
+    if (a_enabled && !m_sleepTracker)
+    {
+        m_sleepTracker = new SleepTracker(GRID_SIZE, m_points, m_constraints, m_constraintCount, m_restingDistance);
+    }
+    else if (!a_enabled)
+    {
+        delete m_sleepTracker;
+        m_sleepTracker = nullptr;
+        updateAwakeSelection();
+    }
+}
+
+size_t Cloth::getActivePointCount()const
+{
+    return m_sleepTracker ? m_sleepTracker->getActivePointCount() : m_pointCount;
+}
+
+size_t Cloth::getSleepingPointCount()const
+{
+    return m_sleepTracker ? m_sleepTracker->getSleepingPointCount() : 0;
+}
+
+void Cloth::setTethersEnabled(bool a_enabled)
+{
+    if (a_enabled && !m_tethers)
+    {
+        m_tethers = new Tethers(GRID_SIZE, m_points, m_maxDistance);
+    }
+    else if (!a_enabled)
+    {
+        delete m_tethers;
+        m_tethers = nullptr;
+    }
+}
+
+void Cloth::setTiledExecution(size_t a_innerIterations)
+{
+    m_tileIterations = a_innerIterations;
+    if (m_tileIterations > 0 && !m_tiledSolver)
+    {
+        m_tiledSolver = new TiledSolver(GRID_SIZE, m_points, m_constraints, m_constraintCount);
+        m_tiledSolver->setAwakeConstraints(m_sleepRevision != 0 ? getActiveSleepTracker() : nullptr);
+        printf("Tiled solver uses %zu tiles\n", m_tiledSolver->getTileCount());
+    }
+    else if (m_tileIterations == 0)
+    {
+        delete m_tiledSolver;
+        m_tiledSolver = nullptr;
+    }
+}
+
+Cloth::SolverPipeline Cloth::getDefaultPipeline()
+{
+    return {
+        { SolverStage::Constraints, 1 },
+        { SolverStage::RefitBVH, 1 },
+        { SolverStage::Tethers, 1 },
+        { SolverStage::SelfCollisions, 1 },
+        { SolverStage::RefitBVH, 1 },
+        { SolverStage::SphereCollisions, 1 }
+    };
+}
+
+void Cloth::setSolverPipeline(const SolverPipeline& a_pipeline)
+{
+    if (m_adaptiveTolerance > 0.f && !measuresResidual(a_pipeline))
+    {
+        printf("The solver pipeline never measures the residual the adaptive iterations need, keeping the current pipeline\n");
+        return;
+    }
+    m_pipeline = a_pipeline;
+    m_defaultPipeline = m_pipeline == getDefaultPipeline();
+}
+
+void Cloth::setVertexFormat(VertexFormat a_format)
+{
+    //three component float buffer textures need GL 4.0
+    if (a_format == VertexFormat::GridNormals && !GLAD_GL_VERSION_4_0)
+    {
+        printf("Buffer textures of vec3 are unavailable, keeping the current vertex format\n");
+        return;
+    }
+    if (a_format != m_vertexFormat)
+    {
+        s_vertexLayouts[static_cast<size_t>(m_vertexFormat)]->releaseVertexArrays(m_vertexStream->getBuffer());
+        m_vertexFormat = a_format;
+        delete m_vertexStream;
+        m_vertexStream = new StreamingBuffer(m_pointCount * getVertexSize(m_vertexFormat));
+
+        if (m_positionTexture)
+        {
+            GLState::deleteTexture(m_positionTexture);
+            m_positionTexture = 0;
+        }
+        if (m_vertexFormat == VertexFormat::GridNormals)
+        {
+            //the texture covers every region of the stream, the draw passes the first texel of the current one
+            glGenTextures(1, &m_positionTexture);
+            GLState::bindTexture(2, GL_TEXTURE_BUFFER, m_positionTexture);
+            glTexBuffer(GL_TEXTURE_BUFFER, GL_RGB32F, m_vertexStream->getBuffer());
+        }
+    }
+}
+
+size_t Cloth::getVertexSize(VertexFormat a_format)
+{
+    switch (a_format)
+    {
+    case VertexFormat::Packed:
+        return 4 * sizeof(unsigned short) + sizeof(unsigned int);
+    case VertexFormat::Octahedral:
+        return 3 * sizeof(unsigned short) + 2 * sizeof(char);
+    case VertexFormat::GridNormals:
+        return 3 * sizeof(float);
+    default:
+        return 6 * sizeof(float);
+    }
+}
+
+void Cloth::setCompliance(float a_compliance)
+{
+    for (size_t k = 0; k < m_constraintCount; k++)
+    {
+        m_constraints[k].setCompliance(a_compliance);
+    }
+}
+
+void Cloth::setStretchStiffness(float a_stiffness)
+{
+    m_stretchStiffness = a_stiffness;
+}
+
+void Cloth::useSmallSteps(size_t a_substeps)
+{
+    setSolverType(SolverType::XPBD);
+    setSubstepCount(a_substeps);
+    setIterationCount(1);
+}
+
+void Cloth::updatePinnedPoints()
+{
+    m_pinRevision = Point::getPinRevision();
+    std::vector<size_t> pinnedPoints;
+    pinnedPoints.reserve(m_pinnedPoints.size());
+    for (size_t k = 0; k < m_pointCount; k++)
+    {
+        if (m_points[k].getInvMass() == 0.f)
         {
-            m_points[k].move(FIXED_TIMESTEP);
+            pinnedPoints.push_back(k);
         }
-        for (size_t k = 0; k < NUM_ITERATIONS; k++)
+    }
+    //pins on other cloths also bump the shared revision, which must not make this cloth rebuild its solvers
+    if (pinnedPoints != m_pinnedPoints)
+    {
+        m_pinnedPoints.swap(pinnedPoints);
+        m_pinnedSetRevision++;
+    }
+    for (size_t k = 0; k < m_constraintCount; k++)
+    {
+        m_constraints[k].updateMassWeights();
+    }
+}
+
+void Cloth::step(float a_deltaTime)
+{
+    if (m_pinRevision != Point::getPinRevision())
+    {
+        updatePinnedPoints();
+    }
+    updateAwakeSelection();
+
+    //the specialized steps are unrolled for a fixed iteration count over every point
+    if (m_specializedStep && m_solverType == SolverType::Relaxation && m_adaptiveTolerance <= 0.f && !m_sleepTracker && !m_tiledSolver && m_defaultPipeline)
+    {
+        m_lastIterationCount = m_iterationCount;
+        m_specializedStep(*this, a_deltaTime);
+        return;
+    }
+    if (m_solverType == SolverType::ProjectiveDynamics)
+    {
+        stepProjectiveDynamics(a_deltaTime);
+        return;
+    }
+    if (m_solverType == SolverType::ImplicitEuler)
+    {
+        stepImplicitEuler(a_deltaTime);
+        return;
+    }
+
+    if (m_sleepTracker)
+    {
+        m_sleepTracker->wake(m_spheres, m_pinnedPoints);
+        updateAwakeSelection();
+    }
+
+    integrate(a_deltaTime);
+
+    if (m_solverType == SolverType::XPBD)
+    {
+        for (size_t k = 0; k < m_constraintCount; k++)
         {
-            m_bvh->update();
+            m_constraints[k].resetLambda();
+        }
+    }
 
-            for (size_t k = 0; k < m_constraintCount; k++)
+    const bool adaptive = m_adaptiveTolerance > 0.f;
+    const size_t maxIterations = adaptive ? m_maxAdaptiveIterations : m_iterationCount;
+    m_lastIterationCount = 0;
+    while (m_lastIterationCount < maxIterations)
+    {
+        m_lastIterationCount++;
+        float residual = 0.f;
+        //iterations that skip the constraints measure nothing, so they cannot end the loop
+        bool measured = false;
+        for (auto& stage : m_pipeline)
+        {
+            if (stage.m_iterationInterval > 0 && m_lastIterationCount % stage.m_iterationInterval == 0)
             {
-                m_constraints[k].satisfy();
+                residual = std::max(residual, runStage(stage.m_stage, a_deltaTime));
+                measured = measured || stage.m_stage == SolverStage::Constraints;
             }
+        }
+        if (adaptive && measured && residual < m_adaptiveTolerance)
+        {
+            break;
+        }
+    }
+    for (auto& stage : m_pipeline)
+    {
+        if (stage.m_iterationInterval == 0)
+        {
+            runStage(stage.m_stage, a_deltaTime);
+        }
+    }
+
+    if (m_sleepTracker)
+    {
+        m_sleepTracker->update();
+    }
+}
+
+float Cloth::runStage(SolverStage a_stage, float a_deltaTime)
+{
+    switch (a_stage)
+    {
+    case SolverStage::Constraints:
+        return solveConstraints(a_deltaTime);
+    case SolverStage::Tethers:
+        solveTethers();
+        break;
+    case SolverStage::SelfCollisions:
+        solveSelfCollisions();
+        break;
+    case SolverStage::SphereCollisions:
+        solveSphereCollisions();
+        break;
+    case SolverStage::RefitBVH:
+        m_bvh->update();
+        break;
+    }
+    return 0.f;
+}
+
+void Cloth::stepProjectiveDynamics(float a_deltaTime)
+{
+    //the factor only depends on the step length, stiffness and pinned points, so it is rarely rebuilt
+    m_projectiveDynamics->prepare(a_deltaTime, m_stretchStiffness, m_pinnedSetRevision);
+
+    //the verlet step gives the inertial prediction the solver starts from
+    integrate(a_deltaTime);
+    m_lastIterationCount = m_iterationCount;
+    m_projectiveDynamics->solve(m_iterationCount);
+    solveTethers();
+
+    m_bvh->update();
+    solveSelfCollisions();
+    m_bvh->update();
+    solveSphereCollisions();
+}
+
+void Cloth::stepImplicitEuler(float a_deltaTime)
+{
+    m_lastIterationCount = m_implicitIntegrator->step(a_deltaTime, m_stretchStiffness, m_substepDamping);
+    solveTethers();
 
-            struct PointRefs
+    //collisions are still resolved by projection after the step
+    m_bvh->update();
+    solveSelfCollisions();
+    m_bvh->update();
+    solveSphereCollisions();
+}
+
+void Cloth::integrate(float a_deltaTime)
+{
+    const SleepTracker* sleepTracker = getActiveSleepTracker();
+    if (!sleepTracker)
+    {
+        for (size_t k = 0; k < m_pointCount; k++)
+        {
+            m_points[k].move(a_deltaTime, m_substepDamping);
+        }
+        for (size_t pinned : m_pinnedPoints)
+        {
+            m_points[pinned].undoMove();
+        }
+        return;
+    }
+
+    for (auto& range : sleepTracker->getAwakePointRanges())
+    {
+        for (size_t k = range.m_begin; k < range.m_end; k++)
+        {
+            m_points[k].move(a_deltaTime, m_substepDamping);
+        }
+    }
+    for (size_t pinned : m_pinnedPoints)
+    {
+        if (sleepTracker->isPointAwake(pinned))
+        {
+            m_points[pinned].undoMove();
+        }
+    }
+}
+
+float Cloth::solveConstraints(float a_deltaTime)
+{
+    const SleepTracker* sleepTracker = getActiveSleepTracker();
+
+    //the hierarchical solver runs its coarse levels before the regular constraints
+    if (m_solverType == SolverType::Hierarchical)
+    {
+        m_hierarchicalSolver->solveCoarseLevels(sleepTracker);
+    }
+
+    if (m_tiledSolver)
+    {
+        const float invSqrDeltaTime = m_solverType == SolverType::XPBD ? 1.f / (a_deltaTime * a_deltaTime) : 0.f;
+        return m_tiledSolver->solve(m_tileIterations, invSqrDeltaTime);
+    }
+
+    float residual = 0.f;
+    //without sleeping every constraint is a single range
+    const SleepTracker::Range allConstraints{ 0, m_constraintCount };
+    const SleepTracker::Range* ranges = sleepTracker ? sleepTracker->getAwakeConstraintRanges().data() : &allConstraints;
+    const size_t rangeCount = sleepTracker ? sleepTracker->getAwakeConstraintRanges().size() : 1;
+    if (m_solverType == SolverType::XPBD)
+    {
+        const float invSqrDeltaTime = 1.f / (a_deltaTime * a_deltaTime);
+        for (size_t range = 0; range < rangeCount; range++)
+        {
+            for (size_t k = ranges[range].m_begin; k < ranges[range].m_end; k++)
             {
-                Point* m_p1;
-                Point* m_p2;
-            };
-            std::vector<PointRefs> tempConstraints;
-            size_t totalChecked = 0;
-            for (size_t i = 0; i < m_pointCount; i++)
+                residual = std::max(residual, m_constraints[k].satisfyCompliant(invSqrDeltaTime));
+            }
+        }
+    }
+    else
+    {
+        for (size_t range = 0; range < rangeCount; range++)
+        {
+            for (size_t k = ranges[range].m_begin; k < ranges[range].m_end; k++)
             {
-                auto& p1 = m_points[i];
-                const glm::vec3 pointDstVec(m_sqrRestingDistance, m_sqrRestingDistance, m_sqrRestingDistance);
-                BoundingBox testBox{ p1.getPos() - pointDstVec, p1.getPos() + pointDstVec };
-                auto foundPoints = m_bvh->getPayloadsWithinBox(testBox);
-                for (auto& p2Ptr : foundPoints)
-                {
-                    totalChecked++;
-                    if (&p1 == p2Ptr) { continue; }
-                    auto& p2 = *p2Ptr;
-                    auto diff = p1.getPos() - p2.getPos();
-                    if (glm::dot(diff, diff) <= m_sqrRestingDistance)
-                    {
-                        tempConstraints.push_back(PointRefs{ &p1, &p2 });
-                    }
-                }
+                residual = std::max(residual, m_constraints[k].satisfy());
             }
+        }
+    }
+    return residual;
+}
+
+SleepTracker* Cloth::getActiveSleepTracker()const
+{
+    //the projective dynamics and implicit steps move every point regardless of sleeping
+    if (m_solverType == SolverType::ProjectiveDynamics || m_solverType == SolverType::ImplicitEuler)
+    {
+        return nullptr;
+    }
+    return m_sleepTracker;
+}
+
+void Cloth::updateAwakeSelection()
+{
+    const SleepTracker* sleepTracker = getActiveSleepTracker();
+    const size_t revision = sleepTracker ? sleepTracker->getRevision() : 0;
+    if (revision == m_sleepRevision)
+    {
+        return;
+    }
+    m_sleepRevision = revision;
+
+    m_bvh->setActivePayloads([&](const Point* a_point) { return !sleepTracker || sleepTracker->isPointAwake(static_cast<size_t>(a_point - m_points)); });
+    if (m_tiledSolver)
+    {
+        m_tiledSolver->setAwakeConstraints(sleepTracker);
+    }
+}
 
-            //printf("Checked an average of %F times\n", static_cast<float>(totalChecked) / m_pointCount);
-            for (auto& points : tempConstraints)
+void Cloth::solveTethers()
+{
+    if (m_tethers)
+    {
+        m_tethers->solve(getActiveSleepTracker());
+    }
+}
+
+void Cloth::solveSelfCollisions()
+{
+    struct PointRefs
+    {
+        Point* m_p1;
+        Point* m_p2;
+    };
+    SleepTracker* const sleepTracker = getActiveSleepTracker();
+    std::vector<PointRefs> tempConstraints;
+    size_t totalChecked = 0;
+    //only awake points look for collisions; without sleeping every point is a single range
+    const SleepTracker::Range allPoints{ 0, m_pointCount };
+    const SleepTracker::Range* ranges = sleepTracker ? sleepTracker->getAwakePointRanges().data() : &allPoints;
+    const size_t rangeCount = sleepTracker ? sleepTracker->getAwakePointRanges().size() : 1;
+    for (size_t range = 0; range < rangeCount; range++)
+    {
+        for (size_t i = ranges[range].m_begin; i < ranges[range].m_end; i++)
+        {
+            auto& p1 = m_points[i];
+            const glm::vec3 pointDstVec(m_sqrRestingDistance, m_sqrRestingDistance, m_sqrRestingDistance);
+            BoundingBox testBox{ p1.getPos() - pointDstVec, p1.getPos() + pointDstVec };
+            auto foundPoints = m_bvh->getPayloadsWithinBox(testBox);
+            for (auto& p2Ptr : foundPoints)
             {
-                Constraint tempConstraint(*points.m_p1, *points.m_p2, m_maxDistance, m_maxDistance, 1.f);
-                tempConstraint.satisfy();
+                totalChecked++;
+                if (&p1 == p2Ptr) { continue; }
+                auto& p2 = *p2Ptr;
+                auto diff = p1.getPos() - p2.getPos();
+                if (glm::dot(diff, diff) <= m_sqrRestingDistance)
+                {
+                    tempConstraints.push_back(PointRefs{ &p1, &p2 });
+                }
             }
+        }
+    }
+
+    //printf("Checked an average of %F times\n", static_cast<float>(totalChecked) / m_pointCount);
+    for (auto& points : tempConstraints)
+    {
+        Constraint tempConstraint(*points.m_p1, *points.m_p2, m_maxDistance, m_maxDistance, 1.f);
+        tempConstraint.satisfy();
 
-            m_bvh->update();
+        //a sleeping point pushed away by an awake one is not on the border of its tile
+        const size_t point2 = static_cast<size_t>(points.m_p2 - m_points);
+        if (sleepTracker && !sleepTracker->isPointAwake(point2))
+        {
+            sleepTracker->markMoved(point2);
+        }
+    }
+}
 
-            for (auto& sphere : m_spheres)
+void Cloth::solveSphereCollisions()
+{
+    for (auto& sphere : m_spheres)
+    {
+        auto points = m_bvh->getPayloadsWithinSphere(*sphere);
+        if (!points.empty())
+        {
+            const float sqrRadius = sphere->getRadius() * sphere->getRadius();
+            for (auto& point : points)
             {
-                auto points = m_bvh->getPayloadsWithinSphere(*sphere);
-                if (!points.empty())
+                const auto diff = point->getPos() - sphere->getPos();
+                const float sqrDst = glm::dot(diff, diff);
+                if (sqrDst < sqrRadius)
                 {
-                    const float sqrRadius = sphere->getRadius() * sphere->getRadius();
-                    for (auto& point : points)
-                    {
-                        const auto diff = point->getPos() - sphere->getPos();
-                        const float sqrDst = glm::dot(diff, diff);
-                        if (sqrDst < sqrRadius)
-                        {
-                            const float dst = sqrtf(sqrDst);
-                            point->setPos(point->getPos() + (diff / dst) * (sphere->getRadius() - dst));
-                        }
-                    }
-                    m_bvh->update(); //update BVH again because points were moved
+                    const float dst = sqrtf(sqrDst);
+                    point->setPos(point->getPos() + (diff / dst) * (sphere->getRadius() - dst));
                 }
             }
+            m_bvh->update(); //update BVH again because points were moved
         }
     }
 }
@@ -275,25 +1086,18 @@ void Cloth::removeSphere(Sphere& a_sphere)
 void Cloth::drawSimulation(const Camera& a_camera, bool a_persistent)const
 {
 
-    if (a_persistent)
-    {
-        glDisable(GL_DEPTH_TEST);
-    }
-
+    DebugDrawBatch& batch = getDebugBatch();
     for (size_t k = 0; k < m_pointCount; k++)
     {
-        m_points[k].draw(a_camera);
+        m_points[k].draw(batch);
     }
 
     for (size_t k = 0; k < m_constraintCount; k++)
     {
-        m_constraints[k].draw(a_camera);
+        m_constraints[k].draw(batch);
     }
 
-    if (a_persistent)
-    {
-        glEnable(GL_DEPTH_TEST);
-    }
+    batch.flush(a_camera, a_persistent);
 
 }
 
@@ -304,74 +1108,150 @@ void Cloth::drawBVH(const Camera& a_camera, bool a_persistent)const
 
 void Cloth::draw(const Camera& a_camera)const
 {
-    std::vector<float> data;
+    //the vertices are written straight into the mapped region of this frame
+    unsigned char* const data = static_cast<unsigned char*>(m_vertexStream->beginWrite());
+    const size_t vertexSize = getVertexSize(m_vertexFormat);
 
-    for (size_t k = 0; k < m_pointCount; k++)
+    const float alpha = getInterpolationAlpha();
+    const auto getRenderPos = [&](size_t a_point)
     {
-        VertexNode& node = m_vertices[k];
-        glm::vec3 normal(0, 0, 0);
-        for (auto& triangleindex : node.triangles)
+        return m_interpolateRendering ? glm::mix(m_lastStepPositions[a_point], m_points[a_point].getPos(), alpha) : m_points[a_point].getPos();
+    };
+
+    //the packed formats quantize the positions to 16 bits within the bounds of the cloth
+    glm::vec3 boundsMin(0.f);
+    glm::vec3 boundsExtent(1.f);
+    if (m_vertexFormat == VertexFormat::Packed || m_vertexFormat == VertexFormat::Octahedral)
+    {
+        //every thread reduces its share of the points, then merges it; min and max reductions need a newer OpenMP than MSVC has
+        glm::vec3 boundsMax(-FLT_MAX);
+        boundsMin = glm::vec3(FLT_MAX);
+        const int pointCount = static_cast<int>(m_pointCount);
+        #pragma omp parallel
         {
-            auto& triangle = m_triangles[triangleindex];
-            //normal calculation from https://www.khronos.org/opengl/wiki/Calculating_a_Surface_Normal
-            glm::vec3 u = m_points[triangle.vertices[1]].getPos() - m_points[triangle.vertices[0]].getPos();
-            glm::vec3 v = m_points[triangle.vertices[2]].getPos() - m_points[triangle.vertices[0]].getPos();
-            //printf("u = { %F, %F, %F } v = { %F, %F, %F }\n", u.x, u.y, u.z, v.x, v.y, v.z);
-            normal += glm::vec3((u.y * v.z) - (u.z * v.y), (u.z * v.x) - (u.x * v.z), (u.x * v.y) - (u.y * v.x));
+            glm::vec3 threadMin(FLT_MAX);
+            glm::vec3 threadMax(-FLT_MAX);
+            #pragma omp for nowait
+            for (int k = 0; k < pointCount; k++)
+            {
+                const glm::vec3 position = getRenderPos(k);
+                threadMin = glm::min(threadMin, position);
+                threadMax = glm::max(threadMax, position);
+            }
+            #pragma omp critical
+            {
+                boundsMin = glm::min(boundsMin, threadMin);
+                boundsMax = glm::max(boundsMax, threadMax);
+            }
         }
-        normal = glm::normalize(normal / static_cast<float>(node.triangles.size()));
+        boundsExtent = glm::max(boundsMax - boundsMin, glm::vec3(FLT_EPSILON));
+    }
+    const glm::vec3 invBoundsExtent = 1.f / boundsExtent;
 
-        for (size_t axis = 0; axis < 3; axis++)
+    //the normal of a grid point is the cross product of the central differences to its neighbours along x and y,
+    //falling back to one sided differences on the border; a column is contiguous, so the inner loop streams through memory
+    const size_t DIM_Y = GRID_SIZE.y;
+    const int columnCount = static_cast<int>(GRID_SIZE.x);
+    #pragma omp parallel for
+    for (int x = 0; x < columnCount; x++)
+    {
+        const size_t column = x * DIM_Y;
+        const size_t previousColumn = (x > 0 ? x - 1 : x) * DIM_Y;
+        const size_t nextColumn = (x + 1 < columnCount ? x + 1 : x) * DIM_Y;
+        const auto writeVertex = [&](size_t a_y, size_t a_previousY, size_t a_nextY)
         {
-            data.push_back(m_points[k].getPos()[axis]);
-        }
+            const glm::vec3 position = getRenderPos(column + a_y);
+            unsigned char* vertex = &data[(column + a_y) * vertexSize];
+            if (m_vertexFormat == VertexFormat::GridNormals)
+            {
+                memcpy(vertex, &position, sizeof(glm::vec3));
+                return;
+            }
 
-        for (size_t axis = 0; axis < 3; axis++)
+            const glm::vec3 alongX = getRenderPos(nextColumn + a_y) - getRenderPos(previousColumn + a_y);
+            const glm::vec3 alongY = getRenderPos(column + a_nextY) - getRenderPos(column + a_previousY);
+            const glm::vec3 normal = glm::normalize(glm::cross(alongX, alongY));
+            switch (m_vertexFormat)
+            {
+            case VertexFormat::Float:
+                memcpy(vertex, &position, sizeof(glm::vec3));
+                memcpy(vertex + sizeof(glm::vec3), &normal, sizeof(glm::vec3));
+                break;
+            case VertexFormat::Packed:
+            {
+                const glm::vec3 relativePosition = (position - boundsMin) * invBoundsExtent;
+                const glm::uint16 packedPosition[4] = { quantizeUnorm16(relativePosition.x), quantizeUnorm16(relativePosition.y), quantizeUnorm16(relativePosition.z), 0 };
+                //10 bits per normal component from the lowest bits up, the 2 bit w stays 0
+                const glm::uint32 packedNormal = (static_cast<glm::uint32>(quantizeSnorm(normal.x, 511.f)) & 0x3FF)
+                    | ((static_cast<glm::uint32>(quantizeSnorm(normal.y, 511.f)) & 0x3FF) << 10)
+                    | ((static_cast<glm::uint32>(quantizeSnorm(normal.z, 511.f)) & 0x3FF) << 20);
+                memcpy(vertex, packedPosition, sizeof(packedPosition));
+                memcpy(vertex + sizeof(packedPosition), &packedNormal, sizeof(packedNormal));
+                break;
+            }
+            case VertexFormat::Octahedral:
+            {
+                const glm::vec3 relativePosition = (position - boundsMin) * invBoundsExtent;
+                const glm::uint16 packedPosition[3] = { quantizeUnorm16(relativePosition.x), quantizeUnorm16(relativePosition.y), quantizeUnorm16(relativePosition.z) };
+                const glm::vec2 octahedral = encodeOctahedral(normal);
+                const glm::int8 packedNormal[2] = { static_cast<glm::int8>(quantizeSnorm(octahedral.x, 127.f)), static_cast<glm::int8>(quantizeSnorm(octahedral.y, 127.f)) };
+                memcpy(vertex, packedPosition, sizeof(packedPosition));
+                memcpy(vertex + sizeof(packedPosition), packedNormal, sizeof(packedNormal));
+                break;
+            }
+            default:
+                break;
+            }
+        };
+
+        writeVertex(0, 0, DIM_Y > 1 ? 1 : 0);
+        for (size_t y = 1; y + 1 < DIM_Y; y++)
         {
-            data.push_back(normal[axis]);
+            writeVertex(y, y - 1, y + 1);
+        }
+        if (DIM_Y > 1)
+        {
+            writeVertex(DIM_Y - 1, DIM_Y - 2, DIM_Y - 1);
         }
-
     }
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * data.size(), data.data(), GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    const size_t region = m_vertexStream->endWrite();
+    Shader::setCamera(a_camera);
+    //the vertex array object holds the index buffer as well
+    s_vertexLayouts[static_cast<size_t>(m_vertexFormat)]->bind(m_vertexStream->getBuffer(), m_indexBuffer);
+
+    if (m_vertexFormat == VertexFormat::GridNormals)
+    {
+        //no vertex attributes, the shader fetches the positions of the region by vertex index
+        GLState::bindTexture(2, GL_TEXTURE_BUFFER, m_positionTexture);
+        s_gridShader->bind();
+        s_gridShader->setUniform(s_uniforms.m_gridSize, glm::ivec2(GRID_SIZE));
+        s_gridShader->setUniform(s_uniforms.m_firstTexel, static_cast<int>(region * m_pointCount));
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(getIndexCount()), GL_UNSIGNED_INT, (void*)0);
+        m_vertexStream->fence();
+        return;
+    }
 
     s_shader->bind();
-    s_shader->setUniform("u_vp", a_camera.getView() * a_camera.getProjection());
-    s_vertexLayout->bind();
-    glDrawElements(GL_TRIANGLES, getIndexCount(), GL_UNSIGNED_INT, (void*)0);
+    s_shader->setUniform(s_uniforms.m_positionOffset, boundsMin);
+    s_shader->setUniform(s_uniforms.m_positionScale, boundsExtent);
+    s_shader->setUniform(s_uniforms.m_octahedralNormals, m_vertexFormat == VertexFormat::Octahedral);
+    //every region holds a full set of vertices, so the base vertex selects the region without rebinding the attributes
+    glDrawElementsBaseVertex(GL_TRIANGLES, static_cast<GLsizei>(getIndexCount()), GL_UNSIGNED_INT, (void*)0, static_cast<GLint>(region * m_pointCount));
+    m_vertexStream->fence();
 
 }
 
 void Cloth::createRenderingResources()
 {
-    s_shader = new Shader(
-        "#version 330 core\n"
-        ""
-        "in vec3 a_pos;"
-        "in vec3 a_normal;"
-        ""
-        "uniform mat4 u_vp;"
-        ""
-        "out vec3 v_worldPos;"
-        "out vec3 v_normal;"
-        ""
-        "void main()"
-        "{"
-        "   gl_Position = u_vp * vec4(a_pos, 1.0);"
-        "   v_worldPos = a_pos;"
-        "   v_normal = a_normal;"
-        "}"
-
-        ,
-
+    //both cloth shaders light the surface the same way
+    const char* const fragmentSource =
         "#version 330 core\n"
         ""
         "in vec3 v_worldPos;"
         "in vec3 v_normal;"
         ""
-        "uniform mat4 u_vp;"
+        "layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };"
         "uniform vec3 u_color;"
         "uniform sampler2D u_cellShadingTexture;"
         ""
@@ -414,15 +1294,106 @@ void Cloth::createRenderingResources()
         "   finalColor = hsv2rgb(vec3(hsvColor.rg, texture(u_cellShadingTexture, vec2(hsvColor.b, 0.0))));"
         ""
         "   outColor = vec4(finalColor, 1.0);"
+        "}";
+
+    s_shader = new Shader(
+        "#version 330 core\n"
+        ""
+        "in vec3 a_pos;"
+        "in vec3 a_normal;"
+        ""
+        "layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };"
+        "uniform vec3 u_positionOffset;"
+        "uniform vec3 u_positionScale;"
+        "uniform bool u_octahedralNormals;"
+        ""
+        "out vec3 v_worldPos;"
+        "out vec3 v_normal;"
+        ""
+        "vec3 decodeOctahedral(vec2 e)"
+        "{"
+        "   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));"
+        "   if(n.z < 0.0){ n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0); }"
+        "   return normalize(n);"
+        "}"
+        ""
+        "void main()"
+        "{"
+        "   vec3 worldPos = u_positionOffset + a_pos * u_positionScale;"
+        "   gl_Position = u_vp * vec4(worldPos, 1.0);"
+        "   v_worldPos = worldPos;"
+        "   v_normal = u_octahedralNormals ? decodeOctahedral(a_normal.xy) : a_normal;"
         "}"
+
+        ,
+
+        fragmentSource
+    );
+
+    s_gridShader = new Shader(
+        "#version 330 core\n"
+        ""
+        "layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };"
+        "uniform ivec2 u_gridSize;"
+        "uniform int u_firstTexel;"
+        "uniform samplerBuffer u_positions;"
+        ""
+        "out vec3 v_worldPos;"
+        "out vec3 v_normal;"
+        ""
+        "vec3 fetchPosition(int x, int y)"
+        "{"
+        "   return texelFetch(u_positions, u_firstTexel + x * u_gridSize.y + y).xyz;"
+        "}"
+        ""
+        "void main()"
+        "{"
+        "   int x = gl_VertexID / u_gridSize.y;"
+        "   int y = gl_VertexID % u_gridSize.y;"
+        "   vec3 worldPos = fetchPosition(x, y);"
+        "   vec3 alongX = fetchPosition(min(x + 1, u_gridSize.x - 1), y) - fetchPosition(max(x - 1, 0), y);"
+        "   vec3 alongY = fetchPosition(x, min(y + 1, u_gridSize.y - 1)) - fetchPosition(x, max(y - 1, 0));"
+        "   gl_Position = u_vp * vec4(worldPos, 1.0);"
+        "   v_worldPos = worldPos;"
+        "   v_normal = normalize(cross(alongX, alongY));"
+        "}"
+
+        ,
+
+        fragmentSource
     );
 
     s_shader->setUniform("u_color", glm::vec3(1.f, 1.f, 1.f));
+    s_gridShader->setUniform("u_color", glm::vec3(1.f, 1.f, 1.f));
+    s_gridShader->setUniform("u_positions", 2);
+
+    s_uniforms.m_positionOffset = s_shader->getUniform("u_positionOffset");
+    s_uniforms.m_positionScale = s_shader->getUniform("u_positionScale");
+    s_uniforms.m_octahedralNormals = s_shader->getUniform("u_octahedralNormals");
+    s_uniforms.m_gridSize = s_gridShader->getUniform("u_gridSize");
+    s_uniforms.m_firstTexel = s_gridShader->getUniform("u_firstTexel");
+
+    VertexLayout*& floatLayout = s_vertexLayouts[static_cast<size_t>(VertexFormat::Float)];
+    floatLayout = new VertexLayout();
+    floatLayout->addFloatComponent(3); //pos
+    floatLayout->addFloatComponent(3); //normal
+
+    //the fourth position component only pads the vertex to 4 byte alignment
+    VertexLayout*& packedLayout = s_vertexLayouts[static_cast<size_t>(VertexFormat::Packed)];
+    packedLayout = new VertexLayout();
+    packedLayout->addUShortComponent(4, true); //pos
+    packedLayout->addPackedComponent(true); //normal
+
+    //a missing third normal component reads as 0, so the octahedral xy reach the shader unchanged
+    VertexLayout*& octahedralLayout = s_vertexLayouts[static_cast<size_t>(VertexFormat::Octahedral)];
+    octahedralLayout = new VertexLayout();
+    octahedralLayout->addUShortComponent(3, true); //pos
+    octahedralLayout->addCharComponent(2, true); //normal
 
-    s_vertexLayout = new VertexLayout();
-    s_vertexLayout->addFloatComponent(3); //pos
-    s_vertexLayout->addFloatComponent(3); //normal
+    //the grid shader reads the positions from a texture buffer, so its layout only carries the index buffer
+    s_vertexLayouts[static_cast<size_t>(VertexFormat::GridNormals)] = new VertexLayout();
 
     s_cellShadingTexture = new Texture("Assets/CellShading.png");
     s_shader->setUniform("u_cellShadingTexture", *s_cellShadingTexture, 1);
+    s_gridShader->setUniform("u_cellShadingTexture", *s_cellShadingTexture, 1);
 }
\ No newline at end of file
@@ -1,15 +1,19 @@
 #pragma once
 #include "DebugDrawable.h"
 #include <vector>
+#include <algorithm>
 #include <glm/detail/type_vec2.hpp>
 #include <glm/mat4x4.hpp>
 #include "FrameBuffer.h"
+#include "Transform.h"
 
 class Point;
 class Constraint;
 class Sphere;
 class BVH;
 struct Basis;
+enum class QualityTier;
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY> struct ClothSolver;
 typedef unsigned int GLuint;
 
 class Cloth : public DebugDrawable
@@ -17,6 +21,58 @@ class Cloth : public DebugDrawable
 public:
     static constexpr size_t NUM_ITERATIONS = 4;
     static constexpr float FIXED_TIMESTEP = 1.f / 60.f;
+    //most timesteps a budgeted update carries over to the next one; any time beyond that is dropped
+    static constexpr size_t MAX_CARRIED_STEPS = 4;
+    //updates in a row that have to stay within half the frame budget before a degraded quality tier is raised again
+    static constexpr size_t TIER_RECOVERY_UPDATES = 120;
+    //fraction of the shortest constraint or collider radius a point may travel per adaptive substep
+    static constexpr float ADAPTIVE_DISPLACEMENT_LIMIT = 0.25f;
+
+    enum class SolverType
+    {
+        Relaxation, //jakobsen-style relaxation, stiffness depends on the iteration count
+        XPBD,               //compliance based, stiffness is independent of the iteration count
+        ProjectiveDynamics, //local/global solve with a prefactored system matrix, for big and stiff cloths
+        ImplicitEuler,      //backward euler with a conjugate gradient solve, stays stable with large timesteps
+        Hierarchical        //relaxation that first pulls strided coarse lattices into shape, for big cloths
+    };
+
+    //layouts of the streamed vertices; the packed layouts store positions relative to the bounds of the cloth, decoded in the vertex shader
+    enum class VertexFormat
+    {
+        Float,      //float position and normal, 24 bytes
+        Packed,     //16 bit position and 10:10:10:2 normal, 12 bytes
+        Octahedral, //16 bit position and octahedral 8 bit normal, 8 bytes
+        GridNormals //float position only, 12 bytes; the vertex shader fetches the neighbours from a texture buffer and computes the normal
+    };
+    static constexpr size_t VERTEX_FORMAT_COUNT = 4;
+
+    //signature of the compile time specialized solver steps
+    typedef void(*SolverStepFunction)(Cloth&, float);
+
+    //stages of a relaxation, XPBD or hierarchical step after integration
+    enum class SolverStage
+    {
+        Constraints,
+        Tethers,
+        SelfCollisions,
+        SphereCollisions,
+        RefitBVH
+    };
+
+    struct PipelineStage
+    {
+        SolverStage m_stage;
+        //N runs the stage on every Nth iteration, 0 runs it once per substep after the iterations
+        size_t m_iterationInterval;
+
+        bool operator==(const PipelineStage& a_other)const { return m_stage == a_other.m_stage && m_iterationInterval == a_other.m_iterationInterval; };
+    };
+    //stages in the order they run within an iteration
+    typedef std::vector<PipelineStage> SolverPipeline;
+
+    //every stage in every iteration, with a refit after the constraints and before the sphere collisions, matching the specialized steps
+    static SolverPipeline getDefaultPipeline();
 
     const glm::vec<2, size_t> GRID_SIZE;
 
@@ -29,6 +85,69 @@ public:
     const Point& getPointAt(size_t a_x, size_t a_y)const;
 
     void update(float a_deltaTime);
+    //how far the simulation time is between the last two timesteps, from 0 to 1, for blending them when drawing
+    //an update that ran out of budget leaves more than a timestep carried over, which draws the last completed step instead of extrapolating
+    float getInterpolationAlpha()const { return std::min(m_timer / m_timestep, 1.f); };
+
+    //solver settings; every timestep is split into the given number of substeps
+    void setSolverType(SolverType a_type);
+    //length of the steps the simulation advances by, FIXED_TIMESTEP by default
+    void setTimestep(float a_timestep);
+    //picks the substep length at every update from the fastest point, halving a_maxSubstep until no point would travel further
+    //than ADAPTIVE_DISPLACEMENT_LIMIT or a_minSubstep is reached; overrides the timestep and substep count while enabled, 0 disables it
+    //and goes back to the configured ones
+    void setAdaptiveSubstepping(float a_minSubstep, float a_maxSubstep);
+    void setSubstepCount(size_t a_substeps);
+    void setIterationCount(size_t a_iterations);
+    void setCompliance(float a_compliance);
+    //spring stiffness used by the projective dynamics and implicit euler solvers
+    void setStretchStiffness(float a_stiffness);
+    //XPBD with many substeps of a single iteration each
+    void useSmallSteps(size_t a_substeps);
+    //selects the iteration count of the tier and its specialized relaxation solver
+    void setQualityTier(QualityTier a_tier);
+    //stops the relaxation iterations once the largest relative stretch drops below the tolerance, running at most a_maxIterations
+    //a tolerance of 0 always runs the iteration count; rejected while the pipeline runs the constraints only once per substep
+    void setAdaptiveIterations(float a_tolerance, size_t a_maxIterations);
+    //lets tiles of the cloth that are at rest fall asleep, skipping them in the integration, constraints, tethers, self collisions
+    //and bvh refit of the relaxation, XPBD and hierarchical solvers; sleeping tiles near a sphere are woken up before the step
+    void setSleepingEnabled(bool a_enabled);
+    //long range attachments from free points to their nearest pinned point, limiting stretch at low iteration counts
+    void setTethersEnabled(bool a_enabled);
+    //solves the constraints in cache sized tiles in parallel, running a_innerIterations passes per tile before the tile borders
+    //are solved; 0 solves the whole grid per pass instead
+    void setTiledExecution(size_t a_innerIterations);
+    //limits the wall clock time an update spends stepping; time that does not fit is carried to the next update, up to MAX_CARRIED_STEPS
+    //timesteps; with a_degradeTier an update over budget lowers the quality tier by one until the load drops; a lowered tier
+    //that does not make the steps faster is undone and stops the degrading until the budget is set again; 0 removes the limit
+    void setFrameBudget(float a_seconds, bool a_degradeTier);
+    //draws the cloth between its last two timesteps at the interpolation alpha, so rendering stays smooth when the steps do not line up with frames
+    void setRenderInterpolation(bool a_enabled);
+    //replaces the stages of the relaxation, XPBD and hierarchical steps; the specialized steps only run the default pipeline
+    //with adaptive iterations the constraints have to run within the iterations, since they report the residual
+    void setSolverPipeline(const SolverPipeline& a_pipeline);
+    //layout of the vertices uploaded every frame; the packed layouts trade normal precision for upload size
+    void setVertexFormat(VertexFormat a_format);
+
+    SolverType getSolverType()const { return m_solverType; };
+    float getTimestep()const { return m_timestep; };
+    size_t getSubstepCount()const { return m_substepCount; };
+    size_t getIterationCount()const { return m_iterationCount; };
+    bool getTethersEnabled()const { return m_tethers != nullptr; };
+    size_t getTileIterationCount()const { return m_tileIterations; };
+    const SolverPipeline& getSolverPipeline()const { return m_pipeline; };
+    VertexFormat getVertexFormat()const { return m_vertexFormat; };
+    //active points are simulated, sleeping points are skipped; every point is active when sleeping is disabled
+    size_t getActivePointCount()const;
+    size_t getSleepingPointCount()const;
+    //number of iterations the last step needed
+    size_t getLastIterationCount()const { return m_lastIterationCount; };
+
+    //moves the points from a_start to a_end over the course of the next update, placing them on the interpolated transform before every substep
+    //a_localPositions holds the position of every point relative to the transform; pinned points follow the path exactly
+    void setKinematicTargets(const std::vector<Point*>& a_points, const std::vector<glm::vec3>& a_localPositions, const Transform& a_start, const Transform& a_end);
+    //same as above for a single point moving in a straight line
+    void setKinematicTarget(Point& a_point, const glm::vec3& a_start, const glm::vec3& a_end);
 
     void addSphere(Sphere& a_sphere);
     void removeSphere(Sphere& a_sphere);
@@ -44,35 +163,121 @@ private:
     size_t m_constraintCount;
 
     BVH* m_bvh;
+    class ProjectiveDynamics* m_projectiveDynamics;
+    class ImplicitIntegrator* m_implicitIntegrator;
+    class HierarchicalSolver* m_hierarchicalSolver;
+    class Tethers* m_tethers;
+    class SleepTracker* m_sleepTracker;
+    //revision of the sleep tracker the bvh and tiled solver were limited to, 0 while they are not limited
+    size_t m_sleepRevision;
+    class TiledSolver* m_tiledSolver;
 
     float m_timer;
     float m_restingDistance;
     float m_maxDistance;
     float m_sqrRestingDistance;
 
+    SolverType m_solverType;
+    float m_timestep;
+    float m_adaptiveMinSubstep;
+    float m_adaptiveMaxSubstep;
+    size_t m_substepCount;
+    //step length set by the user, which adaptive substepping overrides while enabled and restores when disabled
+    float m_configuredTimestep;
+    size_t m_configuredSubstepCount;
+    size_t m_iterationCount;
+    float m_substepDamping;
+    float m_adaptiveTolerance;
+    size_t m_maxAdaptiveIterations;
+    size_t m_lastIterationCount;
+    float m_stretchStiffness;
+    size_t m_tileIterations;
+    //specialized relaxation step for the current tier, null when the iteration count is custom
+    SolverStepFunction m_specializedStep;
+    SolverPipeline m_pipeline;
+    bool m_defaultPipeline;
+
+    float m_frameBudget;
+    bool m_degradeTier;
+    //whether the iteration count comes from a tier, and the tier asked for and currently used
+    bool m_tierSelected;
+    QualityTier m_requestedTier;
+    QualityTier m_qualityTier;
+    size_t m_updatesWithinBudget;
+    //time per step before the tier was last lowered, 0 once the lowered tier was judged
+    float m_stepTimeBeforeDegrade;
+    //set when lowering the tier did not make the steps faster
+    bool m_degradeIneffective;
+
+    //positions at the start of the last timestep, for interpolated rendering
+    bool m_interpolateRendering;
+    std::vector<glm::vec3> m_lastStepPositions;
+
     static class Shader* s_shader;
-    static class VertexLayout* s_vertexLayout;
+    //shader of the GridNormals format
+    static class Shader* s_gridShader;
+    static class VertexLayout* s_vertexLayouts[VERTEX_FORMAT_COUNT];
     static class Texture* s_cellShadingTexture;
 
-    GLuint m_buffer;
+    VertexFormat m_vertexFormat;
+    class StreamingBuffer* m_vertexStream;
+    //texture buffer view of the vertex stream for the GridNormals format, 0 otherwise
+    GLuint m_positionTexture;
     GLuint m_indexBuffer;
     FrameBuffer m_initialRenderTarget;
 
-    struct VertexNode
-    {
-        std::vector<size_t> triangles;
-    };
-    struct TriangleNode
+
+    std::vector<Sphere*> m_spheres;
+
+    struct KinematicGroup
     {
-        size_t vertices[3] = { 0 };
+        std::vector<size_t> m_points;
+        std::vector<glm::vec3> m_localPositions;
+        Transform m_start;
+        Transform m_end;
     };
-    VertexNode* m_vertices;
-    std::vector<TriangleNode> m_triangles;
+    //consumed by the next update
+    std::vector<KinematicGroup> m_kinematicGroups;
 
-    std::vector<Sphere*> m_spheres;
+    //indices of the pinned points in ascending order, rebuilt together with the constraint mass weights when a point is pinned or unpinned
+    std::vector<size_t> m_pinnedPoints;
+    size_t m_pinRevision;
+    //bumped only when the pinned points of this cloth change, unlike the revision shared by every point
+    size_t m_pinnedSetRevision;
 
     static void createRenderingResources();
+    static size_t getVertexSize(VertexFormat a_format);
+
+    //switches the iteration count and specialized step without changing the requested tier
+    void applyQualityTier(QualityTier a_tier);
+    //moves the quality tier one step towards the requested tier depending on the load of the last update
+    void adjustQualityTier(float a_updateTime, float a_stepTime, bool a_overBudget);
+    //changes the step length, keeping the velocity and damping per second the same
+    void setStepLength(float a_timestep, size_t a_substeps);
+    //substep length for adaptive substepping, based on the current velocity of the points
+    float selectAdaptiveSubstep()const;
+
+    void updatePinnedPoints();
+    //places the kinematic points at a_progress of the way between their start and end, from 0 to 1
+    void applyKinematicTargets(float a_progress);
+    void step(float a_deltaTime);
+    void stepProjectiveDynamics(float a_deltaTime);
+    void stepImplicitEuler(float a_deltaTime);
+    void integrate(float a_deltaTime);
+    //the sleep tracker if the current solver lets points sleep, nullptr otherwise
+    class SleepTracker* getActiveSleepTracker()const;
+    //limits the bvh refit and tiled solver to the awake points, or lifts the limit when the current solver does not sleep
+    void updateAwakeSelection();
+    //runs a single pipeline stage; returns the largest relative stretch for the constraints and 0 for the other stages
+    float runStage(SolverStage a_stage, float a_deltaTime);
+    //returns the largest relative stretch before the pass
+    float solveConstraints(float a_deltaTime);
+    void solveTethers();
+    void solveSelfCollisions();
+    void solveSphereCollisions();
+
+    template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY> friend struct ClothSolver;
 
-    size_t getIndexCount()const { return m_triangles.size() * 3; };
+    size_t getIndexCount()const { return (GRID_SIZE.x - 1) * (GRID_SIZE.y - 1) * 6; };
 
 };
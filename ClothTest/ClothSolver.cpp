@@ -0,0 +1,40 @@
+#include "ClothSolver.h"
+
+namespace
+{
+	//walks the list of specialized grid sizes and falls back to the runtime sized solver
+	template<size_t Iterations>
+	Cloth::SolverStepFunction selectForGrid(const glm::vec<2, size_t>&, GridSizeList<>)
+	{
+		return &ClothSolver<Iterations, SOLVER_UNROLL_FACTOR>::step;
+	}
+
+	template<size_t Iterations, size_t X, size_t Y, typename... Rest>
+	Cloth::SolverStepFunction selectForGrid(const glm::vec<2, size_t>& a_gridSize, GridSizeList<GridSize<X, Y>, Rest...>)
+	{
+		if (a_gridSize.x == X && a_gridSize.y == Y)
+		{
+			return &ClothSolver<Iterations, SOLVER_UNROLL_FACTOR, X, Y>::step;
+		}
+		return selectForGrid<Iterations>(a_gridSize, GridSizeList<Rest...>());
+	}
+
+	template<QualityTier Tier>
+	Cloth::SolverStepFunction selectForTier(const glm::vec<2, size_t>& a_gridSize)
+	{
+		return selectForGrid<getTierIterationCount(Tier)>(a_gridSize, SpecializedGridSizes());
+	}
+}
+
+Cloth::SolverStepFunction selectSolverStep(QualityTier a_tier, const glm::vec<2, size_t>& a_gridSize)
+{
+	switch (a_tier)
+	{
+	case QualityTier::Low:
+		return selectForTier<QualityTier::Low>(a_gridSize);
+	case QualityTier::High:
+		return selectForTier<QualityTier::High>(a_gridSize);
+	default:
+		return selectForTier<QualityTier::Medium>(a_gridSize);
+	}
+}
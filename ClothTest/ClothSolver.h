@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include "Cloth.h"
+#include "Point.h"
+
+//quality tiers the runtime dispatcher can select between
+enum class QualityTier
+{
+	Low,
+	Medium,
+	High
+};
+
+//returns the number of relaxation iterations used by the given tier
+constexpr size_t getTierIterationCount(QualityTier a_tier)
+{
+	return a_tier == QualityTier::Low ? 2 : (a_tier == QualityTier::High ? 8 : Cloth::NUM_ITERATIONS);
+}
+
+//size of the cache the fused sweep keeps its two most recent grid columns in
+constexpr size_t FUSED_SWEEP_CACHE_SIZE = 32 * 1024;
+
+//relaxation solver core with its iteration count, loop unroll factor and (optionally) grid dimensions known at compile time
+//a grid dimension of zero means the dimension is only known at runtime
+template<size_t Iterations, size_t UnrollFactor, size_t DimX = 0, size_t DimY = 0>
+struct ClothSolver
+{
+	static_assert(Iterations > 0, "the solver needs at least one iteration");
+	static_assert(UnrollFactor > 0, "the unroll factor needs to be at least one");
+	static_assert((DimX == 0) == (DimY == 0), "either both or none of the grid dimensions are fixed");
+
+	static constexpr bool FIXED_GRID = DimX != 0;
+	static constexpr size_t POINT_COUNT = DimX * DimY;
+	static constexpr size_t CONSTRAINT_COUNT = FIXED_GRID ? (2 * (DimX - 1) * (DimY - 1)) + (DimX - 1) + (DimY - 1) : 0;
+	//fixed grids whose columns fit in cache integrate, project onto the colliders and satisfy the constraints in a single sweep
+	static constexpr bool FUSED = FIXED_GRID && (2 * DimY * sizeof(Point)) <= FUSED_SWEEP_CACHE_SIZE;
+
+	//runs one relaxation step on the given cloth
+	//debug builds check a fused step against the reference step every FUSION_VERIFY_INTERVAL steps and assert they agree;
+	//define CLOTH_VERIFY_FUSION to check every fused step, also in release builds
+	static void step(Cloth& a_cloth, float a_deltaTime);
+
+	//separate passes over all points for every phase
+	static void stepReference(Cloth& a_cloth, float a_deltaTime);
+	//single sweep per iteration; see FUSED
+	static void stepFused(Cloth& a_cloth, float a_deltaTime);
+
+private:
+	//moves every point (first iteration) or projects it out of the colliders (later iterations),
+	//followed by the constraints the constructor created for it
+	template<bool FirstIteration>
+	static void sweepFused(Cloth& a_cloth, float a_deltaTime);
+	static void verifyFusedStep(Cloth& a_cloth, float a_deltaTime);
+};
+
+//largest distance between the fused and reference results that the verification accepts
+constexpr float FUSION_TOLERANCE = 0.0001f;
+//number of fused steps between two verified ones in debug builds
+constexpr size_t FUSION_VERIFY_INTERVAL = 64;
+
+//grid sizes that get a fully specialized fast path; add an entry here for every fixed size character cloth
+template<size_t X, size_t Y>
+struct GridSize {};
+template<typename... Sizes>
+struct GridSizeList {};
+using SpecializedGridSizes = GridSizeList<
+	GridSize<44, 26> //ghost
+>;
+
+//number of calls the point and constraint loops of the reference step are unrolled by
+//the constraints of a Gauss-Seidel pass share points, so this only unrolls scalar calls and does not vectorize;
+//unrolling by 4 or 8 measured no faster than 1
+constexpr size_t SOLVER_UNROLL_FACTOR = 1;
+
+//returns the fastest step function for the given tier and grid size
+Cloth::SolverStepFunction selectSolverStep(QualityTier a_tier, const glm::vec<2, size_t>& a_gridSize);
+
+//include templated/inline function
+#include "ClothSolver.inl"
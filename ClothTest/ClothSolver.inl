@@ -0,0 +1,231 @@
+#pragma once
+#include "ClothSolver.h"//for intellisense - cancelled out by pragma once
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+#include <glm/geometric.hpp>
+#include "Point.h"
+#include "Constraint.h"
+#include "Sphere.h"
+#include "BVH.h"
+
+namespace ClothSolverDetail
+{
+	//calls the function once for every index, fully unrolled at compile time
+	template<typename Function, size_t... Indices>
+	inline void unroll(Function&& a_function, std::index_sequence<Indices...>)
+	{
+		(a_function(Indices), ...);
+	}
+
+	template<size_t Count, typename Function>
+	inline void unroll(Function&& a_function)
+	{
+		unroll(a_function, std::make_index_sequence<Count>());
+	}
+
+	//runs the function over [0, a_count) in unrolled groups of Factor calls, followed by the remainder
+	template<size_t Factor, typename Function>
+	inline void forEachBatched(size_t a_count, Function&& a_function)
+	{
+		size_t k = 0;
+		for (; k + Factor <= a_count; k += Factor)
+		{
+			unroll<Factor>([&](size_t a_lane) { a_function(k + a_lane); });
+		}
+		for (; k < a_count; k++)
+		{
+			a_function(k);
+		}
+	}
+
+	//same projection as Cloth::solveSphereCollisions, for a single point
+	inline void projectOutOfSpheres(Point& a_point, const std::vector<Sphere*>& a_spheres)
+	{
+		for (auto& sphere : a_spheres)
+		{
+			const auto diff = a_point.getPos() - sphere->getPos();
+			const float sqrDst = glm::dot(diff, diff);
+			if (sqrDst < sphere->getRadius() * sphere->getRadius())
+			{
+				const float dst = sqrtf(sqrDst);
+				a_point.setPos(a_point.getPos() + (diff / dst) * (sphere->getRadius() - dst));
+			}
+		}
+	}
+}
+
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY>
+void ClothSolver<Iterations, UnrollFactor, DimX, DimY>::step(Cloth& a_cloth, float a_deltaTime)
+{
+	if constexpr (FUSED)
+	{
+#if defined(CLOTH_VERIFY_FUSION)
+		verifyFusedStep(a_cloth, a_deltaTime);
+#elif !defined(NDEBUG)
+		static size_t s_fusedStepCount = 0;
+		if (s_fusedStepCount++ % FUSION_VERIFY_INTERVAL == 0)
+		{
+			verifyFusedStep(a_cloth, a_deltaTime);
+		}
+		else
+		{
+			stepFused(a_cloth, a_deltaTime);
+		}
+#else
+		stepFused(a_cloth, a_deltaTime);
+#endif
+	}
+	else
+	{
+		stepReference(a_cloth, a_deltaTime);
+	}
+}
+
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY>
+void ClothSolver<Iterations, UnrollFactor, DimX, DimY>::stepReference(Cloth& a_cloth, float a_deltaTime)
+{
+	using namespace ClothSolverDetail;
+
+	//bounds are compile time constants for fixed grids
+	const size_t pointCount = FIXED_GRID ? POINT_COUNT : a_cloth.m_pointCount;
+	const size_t constraintCount = FIXED_GRID ? CONSTRAINT_COUNT : a_cloth.m_constraintCount;
+	assert(!FIXED_GRID || (a_cloth.GRID_SIZE.x == DimX && a_cloth.GRID_SIZE.y == DimY));
+
+	Point* const points = a_cloth.m_points;
+	Constraint* const constraints = a_cloth.m_constraints;
+	const float damping = a_cloth.m_substepDamping;
+
+	forEachBatched<UnrollFactor>(pointCount, [&](size_t a_index) { points[a_index].move(a_deltaTime, damping); });
+	for (size_t pinned : a_cloth.m_pinnedPoints)
+	{
+		points[pinned].undoMove();
+	}
+
+	unroll<Iterations>([&](size_t)
+	{
+		forEachBatched<UnrollFactor>(constraintCount, [&](size_t a_index) { constraints[a_index].satisfy(); });
+		//refit after the constraints, so the self collisions see their result
+		a_cloth.m_bvh->update();
+		a_cloth.solveTethers();
+		a_cloth.solveSelfCollisions();
+		a_cloth.m_bvh->update();
+		a_cloth.solveSphereCollisions();
+	});
+}
+
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY>
+void ClothSolver<Iterations, UnrollFactor, DimX, DimY>::stepFused(Cloth& a_cloth, float a_deltaTime)
+{
+	static_assert(FIXED_GRID, "the fused sweep needs the constraint layout of a fixed grid");
+	assert(a_cloth.GRID_SIZE.x == DimX && a_cloth.GRID_SIZE.y == DimY);
+
+	//the collider projection of an iteration is deferred into the sweep of the next one, which reaches every point
+	//before any of the constraints that move it; only the last iteration needs a separate collider pass
+	sweepFused<true>(a_cloth, a_deltaTime);
+	for (size_t iteration = 1; iteration <= Iterations; iteration++)
+	{
+		a_cloth.m_bvh->update();
+		a_cloth.solveTethers();
+		a_cloth.solveSelfCollisions();
+		if (iteration < Iterations)
+		{
+			sweepFused<false>(a_cloth, a_deltaTime);
+		}
+	}
+
+	Point* const points = a_cloth.m_points;
+	for (size_t point = 0; point < POINT_COUNT; point++)
+	{
+		ClothSolverDetail::projectOutOfSpheres(points[point], a_cloth.m_spheres);
+	}
+}
+
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY>
+template<bool FirstIteration>
+void ClothSolver<Iterations, UnrollFactor, DimX, DimY>::sweepFused(Cloth& a_cloth, float a_deltaTime)
+{
+	Point* const points = a_cloth.m_points;
+	Constraint* const constraints = a_cloth.m_constraints;
+	const float damping = a_cloth.m_substepDamping;
+
+	//the constraints of a point only reach back to its left and upper neighbour, which the sweep already visited
+	size_t constraint = 0;
+	//the pinned points are sorted, so the sweep walks along with them
+	const size_t* nextPinned = a_cloth.m_pinnedPoints.data();
+	const size_t* const pinnedEnd = nextPinned + a_cloth.m_pinnedPoints.size();
+	for (size_t x = 0; x < DimX; x++)
+	{
+		for (size_t y = 0; y < DimY; y++)
+		{
+			const size_t index = (x * DimY) + y;
+			auto& point = points[index];
+			if constexpr (FirstIteration)
+			{
+				point.move(a_deltaTime, damping);
+				if (nextPinned != pinnedEnd && *nextPinned == index)
+				{
+					point.undoMove();
+					nextPinned++;
+				}
+			}
+			else
+			{
+				ClothSolverDetail::projectOutOfSpheres(point, a_cloth.m_spheres);
+			}
+
+			if (x > 0)
+			{
+				constraints[constraint++].satisfy();
+			}
+			if (y > 0)
+			{
+				constraints[constraint++].satisfy();
+			}
+		}
+	}
+	assert(constraint == CONSTRAINT_COUNT);
+}
+
+template<size_t Iterations, size_t UnrollFactor, size_t DimX, size_t DimY>
+void ClothSolver<Iterations, UnrollFactor, DimX, DimY>::verifyFusedStep(Cloth& a_cloth, float a_deltaTime)
+{
+	Point* const points = a_cloth.m_points;
+	const size_t pointCount = a_cloth.m_pointCount;
+	std::vector<glm::vec3> startPositions(pointCount);
+	std::vector<glm::vec3> startPrevious(pointCount);
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		startPositions[k] = points[k].getPos();
+		startPrevious[k] = points[k].getPreviousPos();
+	}
+
+	stepReference(a_cloth, a_deltaTime);
+	std::vector<glm::vec3> reference(pointCount);
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		reference[k] = points[k].getPos();
+		points[k].setPos(startPrevious[k]);
+		points[k].resetPrevious();
+		points[k].setPos(startPositions[k]);
+	}
+
+	stepFused(a_cloth, a_deltaTime);
+	float maxDifference = 0.f;
+	size_t worstPoint = 0;
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		const float difference = glm::length(points[k].getPos() - reference[k]);
+		if (difference > maxDifference)
+		{
+			maxDifference = difference;
+			worstPoint = k;
+		}
+	}
+	if (maxDifference > FUSION_TOLERANCE)
+	{
+		printf("Fused step differs from the reference by %f at point %zu\n", maxDifference, worstPoint);
+	}
+	assert(maxDifference <= FUSION_TOLERANCE);
+}
@@ -1,7 +1,10 @@
 #include "Constraint.h"
-#include <glad/glad.h>
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
 #include <glm/geometric.hpp>
 #include "Point.h"
+#include "DebugDrawBatch.h"
 
 Constraint::Constraint()
 	: m_point1(nullptr)
@@ -11,9 +14,15 @@ Constraint::Constraint()
 	, m_maxLength(0.f)
 	, m_sqrMaxLength(0.f)
 	, m_bendCoefficient(0.f)
+	, m_compliance(0.f)
+	, m_lambda(0.f)
+	, m_weight1(0.f)
+	, m_weight2(0.f)
+	, m_invMass1(0.f)
+	, m_invMass2(0.f)
 {}
 
-Constraint::Constraint(Point& a_point1, Point& a_point2, float a_restLength, float a_maxLength, float a_bendCoefficient)
+Constraint::Constraint(Point& a_point1, Point& a_point2, float a_restLength, float a_maxLength, float a_bendCoefficient, float a_compliance)
     : m_point1(&a_point1)
     , m_point2(&a_point2)
 	, m_restLength(a_restLength)
@@ -21,39 +30,79 @@ Constraint::Constraint(Point& a_point1, Point& a_point2, float a_restLength, flo
 	, m_maxLength(a_maxLength)
 	, m_sqrMaxLength(a_maxLength * a_maxLength)
 	, m_bendCoefficient(a_bendCoefficient)
-{}
+	, m_compliance(a_compliance)
+	, m_lambda(0.f)
+{
+	updateMassWeights();
+}
+
+float Constraint::satisfy()
+{
+	auto& p1 = m_point1->getPos();
+	auto& p2 = m_point2->getPos();
+	auto delta = p2 - p1;
+
+	float dst = glm::length(delta);
+	const float targetLength = m_maxLength * m_restLength;
+	//coincident points get no correction instead of a NaN, which the zero weight of a pinned point would not cancel
+	glm::vec3 correction = (delta / std::max(dst, FLT_EPSILON)) * (dst - targetLength) * m_bendCoefficient;
+	//pinned points have a weight of zero, so they stay in place without a branch
+	m_point1->setPos(p1 + (correction * m_weight1));
+	m_point2->setPos(p2 - (correction * m_weight2));
+
+	return fabsf(dst - targetLength) / targetLength;
+}
 
-void Constraint::satisfy()
+float Constraint::satisfyCompliant(float a_invSqrDeltaTime)
 {
 	auto& p1 = m_point1->getPos();
 	auto& p2 = m_point2->getPos();
 	auto delta = p2 - p1;
 
-	float p1_im = m_point1->getInvMass();
-	float p2_im = m_point2->getInvMass();
+	float alphaTilde = m_compliance * a_invSqrDeltaTime;
+	//the denominator is only zero for rigid constraints between two pinned points, whose corrections are zeroed anyway
+	float denominator = std::max(m_invMass1 + m_invMass2 + alphaTilde, FLT_EPSILON);
 
 	float dst = glm::length(delta);
-	glm::vec3 correction = (delta / dst) * (dst - m_maxLength * m_restLength) * m_bendCoefficient;
-	float m1 = p1_im / (p1_im + p2_im);
-	float m2 = p2_im / (p1_im + p2_im);
-	if (p1_im != 0.f)
+	if (dst <= 0.f)
 	{
-		m_point1->setPos(p1 + (correction * m1));
-	}
-	if (p2_im != 0.f)
-	{
-		m_point2->setPos(p2 - (correction * m2));
+		return 0.f;
 	}
 
+	//the multiplier update makes the stiffness independent of the iteration and substep count
+	float deltaLambda = (-(dst - m_restLength) - (alphaTilde * m_lambda)) / denominator;
+	m_lambda += deltaLambda;
+	glm::vec3 correction = (delta / dst) * deltaLambda;
+	m_point1->setPos(p1 - (correction * m_invMass1));
+	m_point2->setPos(p2 + (correction * m_invMass2));
+	return fabsf(dst - m_restLength) / m_restLength;
+}
+
+void Constraint::resetLambda()
+{
+	m_lambda = 0.f;
+}
+
+void Constraint::updateMassWeights()
+{
+	m_invMass1 = m_point1->getInvMass();
+	m_invMass2 = m_point2->getInvMass();
+	const float invMassSum = m_invMass1 + m_invMass2;
+	m_weight1 = invMassSum > 0.f ? m_invMass1 / invMassSum : 0.f;
+	m_weight2 = invMassSum > 0.f ? m_invMass2 / invMassSum : 0.f;
 }
 
-void Constraint::draw(const Camera& a_camera)const
+void Constraint::setCompliance(float a_compliance)
 {
+	m_compliance = a_compliance;
+}
 
-	float data[12]{
-		m_point1->getPos().x, m_point1->getPos().y, m_point1->getPos().z, 1.f, 0.f, 0.f,
-		m_point2->getPos().x, m_point2->getPos().y, m_point2->getPos().z, 1.f, 0.f, 0.f
-	};
+float Constraint::getCompliance()const
+{
+	return m_compliance;
+}
 
-	drawData(a_camera, GL_LINES, sizeof(data), data, 2);
+void Constraint::draw(DebugDrawBatch& a_batch)const
+{
+	a_batch.addLine(m_point1->getPos(), m_point2->getPos(), glm::vec3(1.f, 0.f, 0.f));
 }
@@ -6,7 +6,7 @@ class Point;
 class Constraint : public DebugDrawable
 {
 public:
-    Constraint(Point& a_point1, Point& a_point2, float a_restLength, float a_maxLength, float a_bendCoefficient);
+    Constraint(Point& a_point1, Point& a_point2, float a_restLength, float a_maxLength, float a_bendCoefficient, float a_compliance = 0.f);
 
     Constraint();
     Constraint(const Constraint&) = delete;
@@ -14,9 +14,25 @@ public:
     Constraint& operator=(Constraint&&) = default;
     Constraint& operator=(const Constraint&) = delete;
 
-    void satisfy();
+    //both projections return the relative stretch of the constraint before it was corrected
+    float satisfy();
 
-    void draw(const Camera& a_camera)const;
+    //XPBD projection; a_invSqrDeltaTime is 1 / (substep length squared)
+    float satisfyCompliant(float a_invSqrDeltaTime);
+    void resetLambda();
+
+    //recomputes the mass weights from the inverse masses of the points; call after pinning or unpinning either point
+    void updateMassWeights();
+
+    Point& getPoint1()const { return *m_point1; };
+    Point& getPoint2()const { return *m_point2; };
+    float getRestLength()const { return m_restLength; };
+
+    void setCompliance(float a_compliance);
+    float getCompliance()const;
+
+    //adds a line between the points to the batch
+    void draw(DebugDrawBatch& a_batch)const;
 
 private:
     Point* m_point1;
@@ -28,4 +44,14 @@ private:
     float m_sqrMaxLength;
     float m_bendCoefficient;
 
+    //inverse stiffness and accumulated lagrange multiplier for XPBD
+    float m_compliance;
+    float m_lambda;
+
+    //share of the correction each point takes, and their inverse masses for XPBD; all zero for pinned points
+    float m_weight1;
+    float m_weight2;
+    float m_invMass1;
+    float m_invMass2;
+
 };
@@ -0,0 +1,221 @@
+#include "DebugDrawBatch.h"
+#include <cstring>
+#include <glad/glad.h>
+#include "GLState.h"
+#include <glm/mat4x4.hpp>
+#include "Shader.h"
+#include "VertexLayout.h"
+#include "StreamingBuffer.h"
+#include "Camera.h"
+
+Shader* DebugDrawBatch::s_shader = nullptr;
+Shader* DebugDrawBatch::s_cubeShader = nullptr;
+VertexLayout* DebugDrawBatch::s_layout = nullptr;
+VertexLayout* DebugDrawBatch::s_instanceLayout = nullptr;
+
+DebugDrawBatch::DebugDrawBatch()
+	: m_vertexStream(nullptr)
+	, m_vertexCapacity(0)
+	, m_cubeStream(nullptr)
+	, m_cubeCapacity(0)
+{
+	if (!s_shader)
+	{
+		createRenderingResources();
+	}
+}
+
+DebugDrawBatch::~DebugDrawBatch()
+{
+	if (m_vertexStream)
+	{
+		s_layout->releaseVertexArrays(m_vertexStream->getBuffer());
+		delete m_vertexStream;
+		m_vertexStream = nullptr;
+	}
+	if (m_cubeStream)
+	{
+		s_instanceLayout->releaseVertexArrays(m_cubeStream->getBuffer());
+		delete m_cubeStream;
+		m_cubeStream = nullptr;
+	}
+}
+
+void DebugDrawBatch::addLine(const glm::vec3& a_start, const glm::vec3& a_end, const glm::vec3& a_color)
+{
+	m_lineVertices.push_back({ a_start, a_color });
+	m_lineVertices.push_back({ a_end, a_color });
+}
+
+void DebugDrawBatch::addPoint(const glm::vec3& a_pos, const glm::vec3& a_color)
+{
+	m_points.push_back({ a_pos, a_color });
+}
+
+void DebugDrawBatch::addCube(const glm::vec3& a_center, float a_halfExtent, const glm::vec3& a_color)
+{
+	m_cubes.push_back({ a_center, a_halfExtent, a_color });
+}
+
+void DebugDrawBatch::reserve(StreamingBuffer*& a_stream, size_t& a_capacity, size_t a_count, size_t a_elementSize, VertexLayout& a_layout)
+{
+	if (a_stream && a_count <= a_capacity)
+	{
+		return;
+	}
+	if (a_capacity == 0)
+	{
+		a_capacity = INITIAL_CAPACITY;
+	}
+	while (a_capacity < a_count)
+	{
+		a_capacity *= 2;
+	}
+	if (a_stream)
+	{
+		a_layout.releaseVertexArrays(a_stream->getBuffer());
+		delete a_stream;
+	}
+	a_stream = new StreamingBuffer(a_capacity * a_elementSize);
+}
+
+void DebugDrawBatch::flush(const Camera& a_camera, bool a_persistent)
+{
+	if (m_lineVertices.empty() && m_points.empty() && m_cubes.empty())
+	{
+		return;
+	}
+
+	Shader::setCamera(a_camera);
+	if (a_persistent)
+	{
+		GLState::setEnabled(GL_DEPTH_TEST, false);
+	}
+
+	const size_t vertexCount = m_lineVertices.size() + m_points.size();
+	if (vertexCount > 0)
+	{
+		reserve(m_vertexStream, m_vertexCapacity, vertexCount, sizeof(Vertex), *s_layout);
+		Vertex* vertices = static_cast<Vertex*>(m_vertexStream->beginWrite());
+		memcpy(vertices, m_lineVertices.data(), m_lineVertices.size() * sizeof(Vertex));
+		memcpy(vertices + m_lineVertices.size(), m_points.data(), m_points.size() * sizeof(Vertex));
+		const GLint first = static_cast<GLint>(m_vertexStream->endWrite() * m_vertexCapacity);
+
+		s_shader->bind();
+		s_layout->bind(m_vertexStream->getBuffer());
+		if (!m_lineVertices.empty())
+		{
+			glDrawArrays(GL_LINES, first, static_cast<GLsizei>(m_lineVertices.size()));
+		}
+		if (!m_points.empty())
+		{
+			glPointSize(POINT_SIZE);
+			glDrawArrays(GL_POINTS, first + static_cast<GLint>(m_lineVertices.size()), static_cast<GLsizei>(m_points.size()));
+		}
+		m_vertexStream->fence();
+	}
+
+	if (!m_cubes.empty())
+	{
+		reserve(m_cubeStream, m_cubeCapacity, m_cubes.size(), sizeof(CubeInstance), *s_instanceLayout);
+		memcpy(m_cubeStream->beginWrite(), m_cubes.data(), m_cubes.size() * sizeof(CubeInstance));
+		const size_t region = m_cubeStream->endWrite();
+
+		s_cubeShader->bind();
+		//the instance attributes start at the region, since instanced draws have no base instance before GL 4.2
+		s_instanceLayout->bind(m_cubeStream->getBuffer(), 0, region * m_cubeCapacity * sizeof(CubeInstance));
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(m_cubes.size()));
+		m_cubeStream->fence();
+	}
+
+	if (a_persistent)
+	{
+		GLState::setEnabled(GL_DEPTH_TEST, true);
+	}
+
+	m_lineVertices.clear();
+	m_points.clear();
+	m_cubes.clear();
+}
+
+void DebugDrawBatch::createRenderingResources()
+{
+	const char* const fragmentSource =
+		"#version 330 core\n"
+		""
+		"in vec3 v_color;\n"
+		""
+		"out vec4 outColor;\n"
+		""
+		"void main()\n"
+		"{\n"
+		"	outColor = vec4(v_color, 1.0);\n"
+		"}\n";
+
+	s_shader = new Shader(
+
+		//vertex shader
+		"#version 330 core\n"
+		""
+		"layout(location = 0) in vec3 a_position;\n"
+		"layout(location = 1) in vec3 a_color;\n"
+		""
+		"layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };\n"
+		""
+		"out vec3 v_color;\n"
+		""
+		"void main()\n"
+		"{\n"
+		"	gl_Position = u_vp * vec4(a_position, 1.0);\n"
+		"	v_color = a_color;\n"
+		"}\n"
+
+		,
+
+		//pixel shader
+		fragmentSource
+	);
+
+	s_cubeShader = new Shader(
+
+		//vertex shader
+		"#version 330 core\n"
+		""
+		"layout(location = 0) in vec4 a_centerExtent;\n"
+		"layout(location = 1) in vec3 a_color;\n"
+		""
+		"layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };\n"
+		""
+		"out vec3 v_color;\n"
+		""
+		//corners of a unit cube as 12 triangles
+		"const vec3 corners[36] = vec3[36](\n"
+		"	vec3(-1,-1,-1), vec3(-1,-1, 1), vec3(-1, 1, 1),  vec3( 1, 1,-1), vec3(-1,-1,-1), vec3(-1, 1,-1),\n"
+		"	vec3( 1,-1, 1), vec3(-1,-1,-1), vec3( 1,-1,-1),  vec3( 1, 1,-1), vec3( 1,-1,-1), vec3(-1,-1,-1),\n"
+		"	vec3(-1,-1,-1), vec3(-1, 1, 1), vec3(-1, 1,-1),  vec3( 1,-1, 1), vec3(-1,-1, 1), vec3(-1,-1,-1),\n"
+		"	vec3(-1, 1, 1), vec3(-1,-1, 1), vec3( 1,-1, 1),  vec3( 1, 1, 1), vec3( 1,-1,-1), vec3( 1, 1,-1),\n"
+		"	vec3( 1,-1,-1), vec3( 1, 1, 1), vec3( 1,-1, 1),  vec3( 1, 1, 1), vec3( 1, 1,-1), vec3(-1, 1,-1),\n"
+		"	vec3( 1, 1, 1), vec3(-1, 1,-1), vec3(-1, 1, 1),  vec3( 1, 1, 1), vec3(-1, 1, 1), vec3( 1,-1, 1)\n"
+		");\n"
+		""
+		"void main()\n"
+		"{\n"
+		"	gl_Position = u_vp * vec4(a_centerExtent.xyz + corners[gl_VertexID] * a_centerExtent.w, 1.0);\n"
+		"	v_color = a_color;\n"
+		"}\n"
+
+		,
+
+		//pixel shader
+		fragmentSource
+	);
+
+	s_layout = new VertexLayout();
+	s_layout->addFloatComponent(3); //pos
+	s_layout->addFloatComponent(3); //color
+
+	s_instanceLayout = new VertexLayout();
+	s_instanceLayout->addFloatComponent(4); //center and half extent
+	s_instanceLayout->addFloatComponent(3); //color
+	s_instanceLayout->setDivisor(1);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <glm/vec3.hpp>
+
+class Camera;
+class Shader;
+class VertexLayout;
+class StreamingBuffer;
+
+//collects debug lines, points and cubes and draws every kind with a single draw call when flushed
+//the data goes through streaming buffers that grow to the largest batch seen, so a steady frame allocates nothing
+class DebugDrawBatch
+{
+public:
+	//size of points on screen in pixels
+	static constexpr float POINT_SIZE = 4.f;
+	//vertices and cubes the streaming buffers hold before they grow for the first time
+	static constexpr size_t INITIAL_CAPACITY = 4096;
+
+	DebugDrawBatch();
+	DebugDrawBatch(const DebugDrawBatch&) = delete;
+	DebugDrawBatch& operator=(const DebugDrawBatch&) = delete;
+	~DebugDrawBatch();
+
+	void addLine(const glm::vec3& a_start, const glm::vec3& a_end, const glm::vec3& a_color);
+	void addPoint(const glm::vec3& a_pos, const glm::vec3& a_color);
+	//axis aligned cube, drawn instanced
+	void addCube(const glm::vec3& a_center, float a_halfExtent, const glm::vec3& a_color);
+
+	/// @brief Draws everything added since the last flush and empties the batch
+	/// @param a_camera Camera to draw with
+	/// @param a_persistent Draws on top of the scene, ignoring depth
+	void flush(const Camera& a_camera, bool a_persistent = false);
+
+private:
+	struct Vertex
+	{
+		glm::vec3 m_pos;
+		glm::vec3 m_color;
+	};
+
+	struct CubeInstance
+	{
+		glm::vec3 m_center;
+		float m_halfExtent;
+		glm::vec3 m_color;
+	};
+
+	static Shader* s_shader;
+	static Shader* s_cubeShader;
+	static VertexLayout* s_layout;
+	//the cube corners come from the vertex index, so the cubes only have per instance attributes
+	static VertexLayout* s_instanceLayout;
+
+	static void createRenderingResources();
+
+	//lines first, then points; both are drawn from the same region
+	std::vector<Vertex> m_lineVertices;
+	std::vector<Vertex> m_points;
+	std::vector<CubeInstance> m_cubes;
+
+	StreamingBuffer* m_vertexStream;
+	size_t m_vertexCapacity;
+	StreamingBuffer* m_cubeStream;
+	size_t m_cubeCapacity;
+
+	//makes room for a_count elements of a_elementSize bytes per region, doubling the capacity until they fit
+	//a_layout drops its vertex array objects of the old buffer when it is replaced
+	static void reserve(StreamingBuffer*& a_stream, size_t& a_capacity, size_t a_count, size_t a_elementSize, VertexLayout& a_layout);
+};
@@ -0,0 +1,162 @@
+#include "GLState.h"
+#include <glad/glad.h>
+
+GLuint GLState::s_program = 0;
+bool GLState::s_programKnown = false;
+GLuint GLState::s_vertexArray = 0;
+bool GLState::s_vertexArrayKnown = false;
+GLuint GLState::s_activeTextureUnit = 0;
+bool GLState::s_activeTextureUnitKnown = false;
+std::map<GLenum, GLuint> GLState::s_buffers;
+std::map<std::pair<GLuint, GLenum>, GLuint> GLState::s_textures;
+std::map<GLenum, bool> GLState::s_capabilities;
+
+size_t GLState::s_issuedCalls = 0;
+size_t GLState::s_savedCalls = 0;
+size_t GLState::s_lastIssuedCalls = 0;
+size_t GLState::s_lastSavedCalls = 0;
+
+bool GLState::change(bool a_redundant)
+{
+	if (a_redundant)
+	{
+		s_savedCalls++;
+		return false;
+	}
+	s_issuedCalls++;
+	return true;
+}
+
+void GLState::useProgram(GLuint a_program)
+{
+	if (change(s_programKnown && s_program == a_program))
+	{
+		glUseProgram(a_program);
+		s_program = a_program;
+		s_programKnown = true;
+	}
+}
+
+void GLState::bindVertexArray(GLuint a_vertexArray)
+{
+	if (change(s_vertexArrayKnown && s_vertexArray == a_vertexArray))
+	{
+		glBindVertexArray(a_vertexArray);
+		s_vertexArray = a_vertexArray;
+		s_vertexArrayKnown = true;
+		s_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+void GLState::bindBuffer(GLenum a_target, GLuint a_buffer)
+{
+	auto iter = s_buffers.find(a_target);
+	if (change(iter != s_buffers.end() && iter->second == a_buffer))
+	{
+		glBindBuffer(a_target, a_buffer);
+		s_buffers[a_target] = a_buffer;
+	}
+}
+
+void GLState::bindBufferBase(GLenum a_target, GLuint a_index, GLuint a_buffer)
+{
+	//indexed bindings are not tracked, so this is always issued
+	change(false);
+	glBindBufferBase(a_target, a_index, a_buffer);
+	s_buffers[a_target] = a_buffer;
+}
+
+void GLState::bindTexture(GLuint a_unit, GLenum a_target, GLuint a_texture)
+{
+	if (change(s_activeTextureUnitKnown && s_activeTextureUnit == a_unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + a_unit);
+		s_activeTextureUnit = a_unit;
+		s_activeTextureUnitKnown = true;
+	}
+
+	const auto key = std::make_pair(a_unit, a_target);
+	auto iter = s_textures.find(key);
+	if (change(iter != s_textures.end() && iter->second == a_texture))
+	{
+		glBindTexture(a_target, a_texture);
+		s_textures[key] = a_texture;
+	}
+}
+
+void GLState::setEnabled(GLenum a_capability, bool a_enabled)
+{
+	auto iter = s_capabilities.find(a_capability);
+	if (change(iter != s_capabilities.end() && iter->second == a_enabled))
+	{
+		if (a_enabled)
+		{
+			glEnable(a_capability);
+		}
+		else
+		{
+			glDisable(a_capability);
+		}
+		s_capabilities[a_capability] = a_enabled;
+	}
+}
+
+void GLState::deleteProgram(GLuint a_program)
+{
+	glDeleteProgram(a_program);
+	if (s_program == a_program)
+	{
+		s_programKnown = false;
+	}
+}
+
+void GLState::deleteVertexArray(GLuint a_vertexArray)
+{
+	glDeleteVertexArrays(1, &a_vertexArray);
+	if (s_vertexArray == a_vertexArray)
+	{
+		//deleting the bound vertex array object reverts to the default one
+		s_vertexArray = 0;
+		s_buffers.erase(GL_ELEMENT_ARRAY_BUFFER);
+	}
+}
+
+void GLState::deleteBuffer(GLuint a_buffer)
+{
+	glDeleteBuffers(1, &a_buffer);
+	for (auto iter = s_buffers.begin(); iter != s_buffers.end();)
+	{
+		if (iter->second == a_buffer)
+		{
+			iter = s_buffers.erase(iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+}
+
+void GLState::deleteTexture(GLuint a_texture)
+{
+	glDeleteTextures(1, &a_texture);
+	for (auto iter = s_textures.begin(); iter != s_textures.end();)
+	{
+		if (iter->second == a_texture)
+		{
+			iter = s_textures.erase(iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+}
+
+void GLState::endFrame()
+{
+	s_lastIssuedCalls = s_issuedCalls;
+	s_lastSavedCalls = s_savedCalls;
+	s_issuedCalls = 0;
+	s_savedCalls = 0;
+}
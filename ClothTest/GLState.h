@@ -0,0 +1,56 @@
+#pragma once
+#include <map>
+#include <utility>
+#include <cstddef>
+
+typedef unsigned int GLuint;
+typedef unsigned int GLenum;
+
+//tracks the bound program, buffers, vertex array object, textures and enable flags, skipping the GL calls that would not change them
+//all of these have to go through here, or the tracked state no longer matches the context; state is unknown until first set
+class GLState
+{
+public:
+	static void useProgram(GLuint a_program);
+	static void bindVertexArray(GLuint a_vertexArray);
+	//the index buffer binding belongs to the bound vertex array object, so it is forgotten whenever that changes
+	static void bindBuffer(GLenum a_target, GLuint a_buffer);
+	//binds to an indexed binding point, which also binds to the generic binding of the target
+	static void bindBufferBase(GLenum a_target, GLuint a_index, GLuint a_buffer);
+	//makes a_unit the active texture unit and binds the texture to it
+	static void bindTexture(GLuint a_unit, GLenum a_target, GLuint a_texture);
+	static void setEnabled(GLenum a_capability, bool a_enabled);
+
+	//delete the object and forget where it was bound, since its name can be handed out again
+	static void deleteProgram(GLuint a_program);
+	static void deleteVertexArray(GLuint a_vertexArray);
+	static void deleteBuffer(GLuint a_buffer);
+	static void deleteTexture(GLuint a_texture);
+
+	//stores the counts of the current frame for the getters and starts counting the next one
+	static void endFrame();
+	//state changes passed on to GL during the last frame
+	static size_t getIssuedCallCount() { return s_lastIssuedCalls; };
+	//state changes skipped during the last frame because they matched the tracked state
+	static size_t getSavedCallCount() { return s_lastSavedCalls; };
+
+private:
+	static GLuint s_program;
+	static bool s_programKnown;
+	static GLuint s_vertexArray;
+	static bool s_vertexArrayKnown;
+	static GLuint s_activeTextureUnit;
+	static bool s_activeTextureUnitKnown;
+	static std::map<GLenum, GLuint> s_buffers;
+	//texture per unit and target
+	static std::map<std::pair<GLuint, GLenum>, GLuint> s_textures;
+	static std::map<GLenum, bool> s_capabilities;
+
+	static size_t s_issuedCalls;
+	static size_t s_savedCalls;
+	static size_t s_lastIssuedCalls;
+	static size_t s_lastSavedCalls;
+
+	//counts the call and returns whether it has to be issued
+	static bool change(bool a_redundant);
+};
@@ -1,10 +1,10 @@
 #include "Ghost.h"
-#include <glad/glad.h>
 #include "Input.h"
 #include "KeyboardKey.h"
 #include "Shader.h"
 #include "Point.h"
 #include "Basis.h"
+#include "DebugDrawBatch.h"
 
 Ghost::Ghost(Input& a_input, const glm::vec3& a_initialPos)
 	: m_input(a_input)
@@ -58,10 +58,28 @@ Ghost::Ghost(Input& a_input, const glm::vec3& a_initialPos)
 	m_cloth.addSphere(m_body);
 	m_cloth.addSphere(m_tail);
 
+	//positions of the driven points relative to the ghost; x is right, y is up and z is forward
+	const float handDstX = (m_head.getRadius() + m_leftHand.getRadius() + 1.f);
+	const float handDstY = (m_head.getRadius() + m_leftHand.getRadius() + 2.f);
+	const float tailDst = m_head.getRadius() + (2.f * m_body.getRadius()) + m_tail.getRadius();
+	m_drivenPoints.push_back(m_headPoint);
+	m_drivenLocalPositions.push_back(glm::vec3(0.f, 0.f, m_head.getRadius()));
+	m_drivenPoints.push_back(m_leftHandPoint);
+	m_drivenLocalPositions.push_back(glm::vec3(-handDstX, 0.f, m_leftHand.getRadius() - handDstY));
+	m_drivenPoints.push_back(m_rightHandPoint);
+	m_drivenLocalPositions.push_back(glm::vec3(handDstX, 0.f, m_rightHand.getRadius() - handDstY));
+	for (size_t k = 0; k < TAIL_POINT_COUNT; k++)
+	{
+		auto& dir = m_tailPointDirections[k];
+		m_drivenPoints.push_back(m_tailPoints[k]);
+		m_drivenLocalPositions.push_back(glm::vec3(dir.x * m_tail.getRadius(), -dir.y * m_tail.getRadius(), -tailDst - m_tail.getRadius()));
+	}
+
 	m_head.setPos(m_transf.getPos());
-	m_headPoint->setPos(m_transf.toWorldPos(glm::vec3(0.f, 0.f, m_head.getRadius())));
-	m_leftHandPoint->setPos(m_leftHand.getPos() + (m_transf.getForward() * m_leftHand.getRadius()));
-	m_rightHandPoint->setPos(m_rightHand.getPos() + (m_transf.getForward() * m_rightHand.getRadius()));
+	for (size_t k = 0; k < m_drivenPoints.size(); k++)
+	{
+		m_drivenPoints[k]->setPos(m_transf.toWorldPos(m_drivenLocalPositions[k]));
+	}
 
 	Point::s_gravity = glm::vec3(0, 0, 0);
 	float timer = 0.f;
@@ -84,35 +102,23 @@ Ghost::~Ghost()
 void Ghost::draw(const Camera& a_camera)const
 {
 	m_cloth.draw(a_camera);
-	//m_head.draw(a_camera);
-	//m_leftHand.draw(a_camera);
-	//m_rightHand.draw(a_camera);
-	//m_body.draw(a_camera);
-	//m_tail.draw(a_camera);
+	//Sphere::drawAll(a_camera);
 
-	float pointToDraw[6]{
-		m_headPoint->getPos().x,
-		m_headPoint->getPos().y,
-		m_headPoint->getPos().z,
-		1.f, 0.f, 0.f
-	};
-	glDisable(GL_DEPTH_TEST);
-	drawData(a_camera, GL_POINTS, sizeof(pointToDraw), pointToDraw, 1);
-	glEnable(GL_DEPTH_TEST);
+	DebugDrawBatch& batch = getDebugBatch();
+	batch.addPoint(m_headPoint->getPos(), glm::vec3(1.f, 0.f, 0.f));
+	batch.flush(a_camera, true);
 }
 
 void Ghost::update(float a_deltaTime, bool a_updateTail)
 {
+	const Transform previousTransform = m_transf;
 	updateMovement(a_deltaTime);
 	m_head.setPos(m_transf.getPos());
-	m_headPoint->setPos(m_transf.toWorldPos(glm::vec3(0.f, 0.f, m_head.getRadius())));
 
 	const float handDstX = (m_head.getRadius() + m_leftHand.getRadius() + 1.f);
 	const float handDstY = (m_head.getRadius() + m_leftHand.getRadius() + 2.f);
 	m_leftHand.setPos(m_transf.getPos() + (-m_transf.getForward() * handDstY) + (-m_transf.getRight() * handDstX));
 	m_rightHand.setPos(m_transf.getPos() + (-m_transf.getForward() * handDstY) + (m_transf.getRight() * handDstX));
-	m_leftHandPoint->setPos(m_leftHand.getPos() + (m_transf.getForward() * m_leftHand.getRadius()));
-	m_rightHandPoint->setPos(m_rightHand.getPos() + (m_transf.getForward() * m_rightHand.getRadius()));
 
 	const float bodyDst = (m_head.getRadius() + m_body.getRadius());
 	m_body.setPos(m_transf.getPos() + (-m_transf.getForward() * bodyDst));
@@ -120,11 +126,8 @@ void Ghost::update(float a_deltaTime, bool a_updateTail)
 	const float tailDst = (bodyDst + m_body.getRadius() + m_tail.getRadius());
 	m_tail.setPos(m_transf.getPos() + (-m_transf.getForward() * tailDst));
 
-	for (size_t k = 0; k < TAIL_POINT_COUNT; k++)
-	{
-		auto& dir = m_tailPointDirections[k];
-		m_tailPoints[k]->setPos(m_tail.getPos() + (-m_transf.getForward() * m_tail.getRadius()) + (m_transf.getRight() * dir.x * m_tail.getRadius()) + (-m_transf.getUp() * dir.y * m_tail.getRadius()));
-	}
+	//the driven points follow the movement of this frame gradually over the substeps
+	m_cloth.setKinematicTargets(m_drivenPoints, m_drivenLocalPositions, previousTransform, m_transf);
 
 	m_timer += a_deltaTime;
 	Point::s_globalForces = glm::vec3(sinf(m_timer * 2.f) * 5.f, 0.f, 0.f);
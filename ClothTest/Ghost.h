@@ -1,5 +1,6 @@
 #pragma once
 #include "DebugDrawable.h"
+#include <vector>
 #include "Cloth.h"
 #include "Sphere.h"
 #include "Transform.h"
@@ -35,6 +36,10 @@ private:
 	Point* m_tailPoints[TAIL_POINT_COUNT];
 	glm::vec2 m_tailPointDirections[TAIL_POINT_COUNT];
 
+	//head, hand and tail points, which the cloth moves along with the transform
+	std::vector<Point*> m_drivenPoints;
+	std::vector<glm::vec3> m_drivenLocalPositions;
+
 	float m_timer;
 
 	Cloth m_cloth;
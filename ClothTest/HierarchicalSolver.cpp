@@ -0,0 +1,228 @@
+#include "HierarchicalSolver.h"
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include "Point.h"
+#include "SleepTracker.h"
+
+HierarchicalSolver::HierarchicalSolver(const glm::vec<2, size_t>& a_gridSize, Point* a_points, float a_maxLength)
+	: m_gridSize(a_gridSize)
+	, m_points(a_points)
+	, m_pinRevision(0)
+{
+	//the finest level is the grid itself; its constraints are the regular cloth constraints
+	buildLevel(1, a_maxLength);
+	m_levels.back().m_constraints.clear();
+
+	size_t stride = 2;
+	while (((m_gridSize.x + stride - 2) / stride) + 1 >= MIN_COARSE_SIZE && ((m_gridSize.y + stride - 2) / stride) + 1 >= MIN_COARSE_SIZE)
+	{
+		buildLevel(stride, a_maxLength);
+		buildProlongation(m_levels[m_levels.size() - 2], m_levels.back());
+		stride *= 2;
+	}
+	updateInvMasses();
+}
+
+void HierarchicalSolver::solveCoarseLevels(const SleepTracker* a_sleepTracker)
+{
+	if (m_pinRevision != Point::getPinRevision())
+	{
+		updateInvMasses();
+	}
+
+	//the start positions are taken before anything moves, so every displacement includes the corrections of the coarser levels
+	for (size_t level = 1; level < m_levels.size(); level++)
+	{
+		auto& current = m_levels[level];
+		for (size_t k = 0; k < current.m_points.size(); k++)
+		{
+			current.m_startPositions[k] = m_points[current.m_points[k]].getPos();
+		}
+	}
+
+	for (size_t level = m_levels.size() - 1; level > 0; level--)
+	{
+		auto& current = m_levels[level];
+		solveLevel(current, a_sleepTracker);
+		for (size_t k = 0; k < current.m_points.size(); k++)
+		{
+			current.m_displacements[k] = m_points[current.m_points[k]].getPos() - current.m_startPositions[k];
+		}
+		prolongate(m_levels[level - 1], current, a_sleepTracker);
+	}
+}
+
+size_t HierarchicalSolver::getFineIndex(size_t a_x, size_t a_y, size_t a_stride)const
+{
+	const size_t x = std::min(a_x * a_stride, m_gridSize.x - 1);
+	const size_t y = std::min(a_y * a_stride, m_gridSize.y - 1);
+	return (x * m_gridSize.y) + y;
+}
+
+void HierarchicalSolver::buildLevel(size_t a_stride, float a_maxLength)
+{
+	m_levels.emplace_back();
+	auto& level = m_levels.back();
+	level.m_stride = a_stride;
+	//the last row and column are always included, so the coarse lattice spans the whole cloth
+	level.m_size = glm::vec<2, size_t>(((m_gridSize.x + a_stride - 2) / a_stride) + 1, ((m_gridSize.y + a_stride - 2) / a_stride) + 1);
+
+	for (size_t x = 0; x < level.m_size.x; x++)
+	{
+		for (size_t y = 0; y < level.m_size.y; y++)
+		{
+			const size_t current = level.m_points.size();
+			level.m_points.push_back(getFineIndex(x, y, a_stride));
+
+			//coarse constraints allow as much stretch as the chain of fine constraints they span
+			const size_t fineX = level.m_points.back() / m_gridSize.y;
+			const size_t fineY = level.m_points.back() % m_gridSize.y;
+			if (x > 0)
+			{
+				const size_t leftNeighbour = current - level.m_size.y;
+				const size_t span = fineX - (level.m_points[leftNeighbour] / m_gridSize.y);
+				level.m_constraints.push_back(LevelConstraint{ leftNeighbour, current, static_cast<float>(span) * a_maxLength });
+			}
+			if (y > 0)
+			{
+				const size_t upNeighbour = current - 1;
+				const size_t span = fineY - (level.m_points[upNeighbour] % m_gridSize.y);
+				level.m_constraints.push_back(LevelConstraint{ upNeighbour, current, static_cast<float>(span) * a_maxLength });
+			}
+		}
+	}
+
+	level.m_invMasses.resize(level.m_points.size());
+	level.m_startPositions.resize(level.m_points.size());
+	level.m_displacements.resize(level.m_points.size());
+}
+
+void HierarchicalSolver::buildProlongation(Level& a_fine, const Level& a_coarse)const
+{
+	const size_t stride = a_coarse.m_stride;
+
+	//finds the coarse cell around a fine coordinate along one axis, returning the interpolation factor
+	auto findCell = [&](size_t a_fine, size_t a_coarseSize, size_t a_gridSize, size_t& a_first, size_t& a_second)
+	{
+		a_first = std::min(a_fine / stride, a_coarseSize - 1);
+		a_second = std::min(a_first + 1, a_coarseSize - 1);
+		const size_t firstFine = std::min(a_first * stride, a_gridSize - 1);
+		const size_t secondFine = std::min(a_second * stride, a_gridSize - 1);
+		if (firstFine == a_fine || secondFine == firstFine)
+		{
+			a_second = a_first;
+			return 0.f;
+		}
+		return static_cast<float>(a_fine - firstFine) / static_cast<float>(secondFine - firstFine);
+	};
+
+	std::vector<bool> inCoarseLevel(m_gridSize.x * m_gridSize.y, false);
+	for (size_t point : a_coarse.m_points)
+	{
+		inCoarseLevel[point] = true;
+	}
+
+	for (size_t k = 0; k < a_fine.m_points.size(); k++)
+	{
+		//points that are part of the coarse level already moved while solving it
+		if (inCoarseLevel[a_fine.m_points[k]])
+		{
+			continue;
+		}
+
+		const size_t fineX = a_fine.m_points[k] / m_gridSize.y;
+		const size_t fineY = a_fine.m_points[k] % m_gridSize.y;
+		size_t x0, x1, y0, y1;
+		const float tX = findCell(fineX, a_coarse.m_size.x, m_gridSize.x, x0, x1);
+		const float tY = findCell(fineY, a_coarse.m_size.y, m_gridSize.y, y0, y1);
+
+		a_fine.m_prolongation.push_back(Interpolation{
+			k,
+			{ (x0 * a_coarse.m_size.y) + y0, (x1 * a_coarse.m_size.y) + y0, (x0 * a_coarse.m_size.y) + y1, (x1 * a_coarse.m_size.y) + y1 },
+			{ (1.f - tX) * (1.f - tY), tX * (1.f - tY), (1.f - tX) * tY, tX * tY }
+		});
+	}
+}
+
+void HierarchicalSolver::updateInvMasses()
+{
+	m_pinRevision = Point::getPinRevision();
+	for (auto& level : m_levels)
+	{
+		const size_t radius = level.m_stride / 2;
+		for (size_t k = 0; k < level.m_points.size(); k++)
+		{
+			const size_t fineX = level.m_points[k] / m_gridSize.y;
+			const size_t fineY = level.m_points[k] % m_gridSize.y;
+			level.m_invMasses[k] = m_points[level.m_points[k]].getInvMass();
+			for (size_t x = fineX - std::min(fineX, radius); x <= std::min(fineX + radius, m_gridSize.x - 1); x++)
+			{
+				for (size_t y = fineY - std::min(fineY, radius); y <= std::min(fineY + radius, m_gridSize.y - 1); y++)
+				{
+					if (m_points[(x * m_gridSize.y) + y].getInvMass() == 0.f)
+					{
+						level.m_invMasses[k] = 0.f;
+					}
+				}
+			}
+		}
+	}
+}
+
+void HierarchicalSolver::solveLevel(Level& a_level, const SleepTracker* a_sleepTracker)
+{
+	for (size_t iteration = 0; iteration < COARSE_ITERATIONS; iteration++)
+	{
+		for (auto& constraint : a_level.m_constraints)
+		{
+			const size_t point1 = a_level.m_points[constraint.m_point1];
+			const size_t point2 = a_level.m_points[constraint.m_point2];
+			auto& p1 = m_points[point1];
+			auto& p2 = m_points[point2];
+			const bool p1_asleep = a_sleepTracker && !a_sleepTracker->isPointAwake(point1);
+			const bool p2_asleep = a_sleepTracker && !a_sleepTracker->isPointAwake(point2);
+			const float p1_im = p1_asleep ? 0.f : a_level.m_invMasses[constraint.m_point1];
+			const float p2_im = p2_asleep ? 0.f : a_level.m_invMasses[constraint.m_point2];
+			if (p1_im + p2_im <= 0.f)
+			{
+				continue;
+			}
+
+			//coarse constraints only pull, since the fine cloth between two coarse points may be folded
+			const glm::vec3 delta = p2.getPos() - p1.getPos();
+			const float dst = glm::length(delta);
+			if (dst <= constraint.m_maxLength)
+			{
+				continue;
+			}
+			const glm::vec3 correction = (delta / dst) * (dst - constraint.m_maxLength);
+			if (p1_im != 0.f)
+			{
+				p1.setPos(p1.getPos() + correction * (p1_im / (p1_im + p2_im)));
+			}
+			if (p2_im != 0.f)
+			{
+				p2.setPos(p2.getPos() - correction * (p2_im / (p1_im + p2_im)));
+			}
+		}
+	}
+}
+
+void HierarchicalSolver::prolongate(Level& a_fine, const Level& a_coarse, const SleepTracker* a_sleepTracker)
+{
+	for (auto& interpolation : a_fine.m_prolongation)
+	{
+		const size_t target = a_fine.m_points[interpolation.m_target];
+		auto& point = m_points[target];
+		if (point.getInvMass() == 0.f || (a_sleepTracker && !a_sleepTracker->isPointAwake(target)))
+		{
+			continue;
+		}
+		glm::vec3 displacement(0.f);
+		for (size_t k = 0; k < 4; k++)
+		{
+			displacement += a_coarse.m_displacements[interpolation.m_points[k]] * interpolation.m_weights[k];
+		}
+		point.setPos(point.getPos() + displacement);
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/detail/type_vec2.hpp>
+
+class Point;
+class SleepTracker;
+
+//hierarchical relaxation of the stretch constraints of a grid cloth
+//coarser lattices are made by striding the grid, so corrections travel across the whole cloth in a single cycle
+//unlike a multigrid no residuals are restricted, since the maximum length constraints have no linear residual; each coarse level
+//relaxes the fine points it shares with the grid and its displacement is interpolated onto the finer level
+class HierarchicalSolver
+{
+public:
+	//number of relaxation sweeps per coarse level and cycle
+	static constexpr size_t COARSE_ITERATIONS = 2;
+	//levels are added until the coarsest lattice would be smaller than this in either direction
+	static constexpr size_t MIN_COARSE_SIZE = 3;
+
+	/// @brief Builds the coarse levels of the grid
+	/// @param a_gridSize Size of the finest grid; points are stored column by column
+	/// @param a_points Points of the finest grid
+	/// @param a_maxLength Maximum length of a single fine constraint
+	HierarchicalSolver(const glm::vec<2, size_t>& a_gridSize, Point* a_points, float a_maxLength);
+
+	//solves every coarse level from coarse to fine, prolongating each correction to the next finer level
+	//the finest level is left to the regular constraints; sleeping points are held in place like pinned ones if a sleep tracker is given
+	void solveCoarseLevels(const SleepTracker* a_sleepTracker);
+
+	size_t getLevelCount()const { return m_levels.size(); };
+
+private:
+	//constraint between two points of a level, by index within the level
+	struct LevelConstraint
+	{
+		size_t m_point1;
+		size_t m_point2;
+		float m_maxLength;
+	};
+
+	//bilinear interpolation of the displacement of a coarser level onto a point of the finer level
+	struct Interpolation
+	{
+		size_t m_target;
+		size_t m_points[4];
+		float m_weights[4];
+	};
+
+	struct Level
+	{
+		glm::vec<2, size_t> m_size;
+		size_t m_stride;
+
+		//fine point index per level point
+		std::vector<size_t> m_points;
+		//a level point is pinned when any fine point it represents is pinned
+		std::vector<float> m_invMasses;
+		std::vector<LevelConstraint> m_constraints;
+
+		//positions at the start of the cycle and the resulting displacement
+		std::vector<glm::vec3> m_startPositions;
+		std::vector<glm::vec3> m_displacements;
+
+		//interpolation from the next coarser level for the points that are not part of it
+		std::vector<Interpolation> m_prolongation;
+	};
+
+	glm::vec<2, size_t> m_gridSize;
+	Point* m_points;
+	std::vector<Level> m_levels;
+	size_t m_pinRevision;
+
+	size_t getFineIndex(size_t a_x, size_t a_y, size_t a_stride)const;
+	void buildLevel(size_t a_stride, float a_maxLength);
+	void buildProlongation(Level& a_fine, const Level& a_coarse)const;
+	void updateInvMasses();
+	void solveLevel(Level& a_level, const SleepTracker* a_sleepTracker);
+	void prolongate(Level& a_fine, const Level& a_coarse, const SleepTracker* a_sleepTracker);
+};
@@ -0,0 +1,299 @@
+#include "ImplicitIntegrator.h"
+#include <cmath>
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include "Point.h"
+#include "Constraint.h"
+
+ImplicitIntegrator::ImplicitIntegrator(Point* a_points, size_t a_pointCount, const Constraint* a_constraints, size_t a_constraintCount)
+	: m_points(a_points)
+	, m_pointCount(a_pointCount)
+{
+	m_springPoints1.reserve(a_constraintCount);
+	m_springPoints2.reserve(a_constraintCount);
+	m_restLengths.reserve(a_constraintCount);
+	std::vector<size_t> refCounts(m_pointCount + 1, 0);
+	for (size_t k = 0; k < a_constraintCount; k++)
+	{
+		auto& constraint = a_constraints[k];
+		const size_t point1 = static_cast<size_t>(&constraint.getPoint1() - m_points);
+		const size_t point2 = static_cast<size_t>(&constraint.getPoint2() - m_points);
+		m_springPoints1.push_back(point1);
+		m_springPoints2.push_back(point2);
+		m_restLengths.push_back(constraint.getRestLength());
+		refCounts[point1 + 1]++;
+		refCounts[point2 + 1]++;
+	}
+
+	for (size_t k = 0; k < m_pointCount; k++)
+	{
+		refCounts[k + 1] += refCounts[k];
+	}
+	m_springRefStarts = refCounts;
+	m_springRefs.resize(m_springRefStarts.back());
+	for (size_t k = 0; k < a_constraintCount; k++)
+	{
+		m_springRefs[refCounts[m_springPoints1[k]]++] = SpringRef{ k, m_springPoints2[k], 1.f };
+		m_springRefs[refCounts[m_springPoints2[k]]++] = SpringRef{ k, m_springPoints1[k], -1.f };
+	}
+
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_positions[axis].resize(m_pointCount);
+		m_velocities[axis].resize(m_pointCount);
+		m_springForces[axis].resize(a_constraintCount);
+		m_solution[axis].resize(m_pointCount);
+		m_residual[axis].resize(m_pointCount);
+		m_preconditioned[axis].resize(m_pointCount);
+		m_direction[axis].resize(m_pointCount);
+		m_product[axis].resize(m_pointCount);
+	}
+	for (auto& jacobian : m_jacobians)
+	{
+		jacobian.resize(a_constraintCount);
+	}
+	m_masses.resize(m_pointCount);
+	m_free.resize(m_pointCount);
+	m_preconditioner.resize(m_pointCount);
+}
+
+size_t ImplicitIntegrator::step(float a_deltaTime, float a_stiffness, float a_damping)
+{
+	const int pointCount = static_cast<int>(m_pointCount);
+
+	//gathers the state; the verlet velocity is the displacement of the previous step
+	//pinned points never update their previous position, so they are treated as static
+	const float invDeltaTime = 1.f / a_deltaTime;
+	#pragma omp parallel for
+	for (int k = 0; k < pointCount; k++)
+	{
+		const auto& point = m_points[k];
+		m_free[k] = point.getInvMass() != 0.f ? 1 : 0;
+		const glm::vec3 velocity = m_free[k] ? (point.getPos() - point.getPreviousPos()) * invDeltaTime : glm::vec3(0.f);
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			m_positions[axis][k] = point.getPos()[static_cast<glm::length_t>(axis)];
+			m_velocities[axis][k] = velocity[static_cast<glm::length_t>(axis)];
+		}
+		m_masses[k] = point.getMass();
+	}
+
+	computeSprings(a_stiffness);
+	computeRightHandSide(a_deltaTime);
+	const size_t iterations = solve(a_deltaTime * a_deltaTime);
+
+	//x' = x + h * (v + dv), stored back as a verlet step
+	#pragma omp parallel for
+	for (int k = 0; k < pointCount; k++)
+	{
+		if (!m_free[k])
+		{
+			continue;
+		}
+		glm::vec3 velocity;
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			velocity[static_cast<glm::length_t>(axis)] = (m_velocities[axis][k] + m_solution[axis][k]) * a_damping;
+		}
+		auto& point = m_points[k];
+		point.resetPrevious();
+		point.setPos(point.getPos() + velocity * a_deltaTime);
+	}
+	return iterations;
+}
+
+void ImplicitIntegrator::computeSprings(float a_stiffness)
+{
+	const int springCount = static_cast<int>(m_restLengths.size());
+	#pragma omp parallel for
+	for (int k = 0; k < springCount; k++)
+	{
+		const size_t point1 = m_springPoints1[k];
+		const size_t point2 = m_springPoints2[k];
+		const glm::vec3 delta(
+			m_positions[0][point1] - m_positions[0][point2],
+			m_positions[1][point1] - m_positions[1][point2],
+			m_positions[2][point1] - m_positions[2][point2]
+		);
+		const float length = glm::length(delta);
+		const glm::vec3 direction = length > 0.f ? delta / length : glm::vec3(0.f);
+		const glm::vec3 force = direction * (-a_stiffness * (length - m_restLengths[k]));
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			m_springForces[axis][k] = force[static_cast<glm::length_t>(axis)];
+		}
+
+		//K = k * (d * d^T + (1 - L / l) * (I - d * d^T)); the transverse term is dropped under compression to keep K positive semi-definite
+		const float transverse = length > m_restLengths[k] ? 1.f - (m_restLengths[k] / length) : 0.f;
+		const float along = a_stiffness * (1.f - transverse);
+		const float diagonal = a_stiffness * transverse;
+		m_jacobians[0][k] = along * direction.x * direction.x + diagonal;
+		m_jacobians[1][k] = along * direction.x * direction.y;
+		m_jacobians[2][k] = along * direction.x * direction.z;
+		m_jacobians[3][k] = along * direction.y * direction.y + diagonal;
+		m_jacobians[4][k] = along * direction.y * direction.z;
+		m_jacobians[5][k] = along * direction.z * direction.z + diagonal;
+	}
+}
+
+void ImplicitIntegrator::computeRightHandSide(float a_deltaTime)
+{
+	//b = h * (f + h * -K * v), the change in velocity is 0 for pinned points
+	const int pointCount = static_cast<int>(m_pointCount);
+	const float sqrDeltaTime = a_deltaTime * a_deltaTime;
+	#pragma omp parallel for
+	for (int k = 0; k < pointCount; k++)
+	{
+		if (!m_free[k])
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				m_residual[axis][k] = 0.f;
+			}
+			m_preconditioner[k] = glm::mat3(0.f);
+			continue;
+		}
+
+		const auto& point = m_points[k];
+		glm::vec3 force = point.getForce() + Point::s_globalForces + (Point::s_gravity * m_masses[k]);
+		glm::mat3 diagonalBlock(m_masses[k]);
+		for (size_t ref = m_springRefStarts[k]; ref < m_springRefStarts[k + 1]; ref++)
+		{
+			const auto& springRef = m_springRefs[ref];
+			const size_t spring = springRef.m_spring;
+			const glm::mat3 jacobian(
+				m_jacobians[0][spring], m_jacobians[1][spring], m_jacobians[2][spring],
+				m_jacobians[1][spring], m_jacobians[3][spring], m_jacobians[4][spring],
+				m_jacobians[2][spring], m_jacobians[4][spring], m_jacobians[5][spring]
+			);
+			const glm::vec3 relativeVelocity(
+				m_velocities[0][k] - m_velocities[0][springRef.m_other],
+				m_velocities[1][k] - m_velocities[1][springRef.m_other],
+				m_velocities[2][k] - m_velocities[2][springRef.m_other]
+			);
+			force += glm::vec3(m_springForces[0][spring], m_springForces[1][spring], m_springForces[2][spring]) * springRef.m_sign;
+			force -= (jacobian * relativeVelocity) * a_deltaTime;
+			diagonalBlock += jacobian * sqrDeltaTime;
+		}
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			m_residual[axis][k] = force[static_cast<glm::length_t>(axis)] * a_deltaTime;
+		}
+		m_preconditioner[k] = glm::inverse(diagonalBlock);
+	}
+}
+
+size_t ImplicitIntegrator::solve(float a_sqrDeltaTime)
+{
+	//starts from dv = 0, so the residual is the right hand side
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		std::fill(m_solution[axis].begin(), m_solution[axis].end(), 0.f);
+	}
+	const double threshold = dot(m_residual, m_residual) * static_cast<double>(TOLERANCE) * static_cast<double>(TOLERANCE);
+	precondition(m_residual, m_preconditioned);
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_direction[axis] = m_preconditioned[axis];
+	}
+	double residualDot = dot(m_residual, m_preconditioned);
+
+	const int pointCount = static_cast<int>(m_pointCount);
+	size_t iteration = 0;
+	while (iteration < MAX_ITERATIONS && dot(m_residual, m_residual) > threshold)
+	{
+		iteration++;
+		multiply(a_sqrDeltaTime, m_direction, m_product);
+		const double curvature = dot(m_direction, m_product);
+		if (curvature <= 0.0)
+		{
+			break;
+		}
+		const float alpha = static_cast<float>(residualDot / curvature);
+		#pragma omp parallel for
+		for (int k = 0; k < pointCount; k++)
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				m_solution[axis][k] += m_direction[axis][k] * alpha;
+				m_residual[axis][k] -= m_product[axis][k] * alpha;
+			}
+		}
+
+		precondition(m_residual, m_preconditioned);
+		const double newResidualDot = dot(m_residual, m_preconditioned);
+		const float beta = static_cast<float>(newResidualDot / residualDot);
+		residualDot = newResidualDot;
+		#pragma omp parallel for
+		for (int k = 0; k < pointCount; k++)
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				m_direction[axis][k] = m_preconditioned[axis][k] + m_direction[axis][k] * beta;
+			}
+		}
+	}
+	return iteration;
+}
+
+void ImplicitIntegrator::multiply(float a_sqrDeltaTime, const Buffer& a_source, Buffer& a_target)const
+{
+	const int pointCount = static_cast<int>(m_pointCount);
+	#pragma omp parallel for
+	for (int k = 0; k < pointCount; k++)
+	{
+		if (!m_free[k])
+		{
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				a_target[axis][k] = 0.f;
+			}
+			continue;
+		}
+
+		const glm::vec3 source(a_source[0][k], a_source[1][k], a_source[2][k]);
+		glm::vec3 springTerm(0.f);
+		for (size_t ref = m_springRefStarts[k]; ref < m_springRefStarts[k + 1]; ref++)
+		{
+			const auto& springRef = m_springRefs[ref];
+			const size_t spring = springRef.m_spring;
+			const size_t other = springRef.m_other;
+			const glm::vec3 difference = m_free[other] ? source - glm::vec3(a_source[0][other], a_source[1][other], a_source[2][other]) : source;
+			springTerm.x += m_jacobians[0][spring] * difference.x + m_jacobians[1][spring] * difference.y + m_jacobians[2][spring] * difference.z;
+			springTerm.y += m_jacobians[1][spring] * difference.x + m_jacobians[3][spring] * difference.y + m_jacobians[4][spring] * difference.z;
+			springTerm.z += m_jacobians[2][spring] * difference.x + m_jacobians[4][spring] * difference.y + m_jacobians[5][spring] * difference.z;
+		}
+		const glm::vec3 result = source * m_masses[k] + springTerm * a_sqrDeltaTime;
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			a_target[axis][k] = result[static_cast<glm::length_t>(axis)];
+		}
+	}
+}
+
+void ImplicitIntegrator::precondition(const Buffer& a_source, Buffer& a_target)const
+{
+	const int pointCount = static_cast<int>(m_pointCount);
+	#pragma omp parallel for
+	for (int k = 0; k < pointCount; k++)
+	{
+		const glm::vec3 result = m_preconditioner[k] * glm::vec3(a_source[0][k], a_source[1][k], a_source[2][k]);
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			a_target[axis][k] = result[static_cast<glm::length_t>(axis)];
+		}
+	}
+}
+
+double ImplicitIntegrator::dot(const Buffer& a_first, const Buffer& a_second)const
+{
+	const int pointCount = static_cast<int>(m_pointCount);
+	double result = 0.0;
+	#pragma omp parallel for reduction(+:result)
+	for (int k = 0; k < pointCount; k++)
+	{
+		result += static_cast<double>(a_first[0][k]) * a_second[0][k] + static_cast<double>(a_first[1][k]) * a_second[1][k] + static_cast<double>(a_first[2][k]) * a_second[2][k];
+	}
+	return result;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <vector>
+#include <glm/mat3x3.hpp>
+
+class Point;
+class Constraint;
+
+//backward euler integrator for the stretch springs of a cloth, in the style of baraff and witkin
+//the linearised system is solved with a matrix-free preconditioned conjugate gradient over structure of arrays buffers
+class ImplicitIntegrator
+{
+public:
+	static constexpr size_t MAX_ITERATIONS = 256;
+	static constexpr float TOLERANCE = 1e-4f;
+
+	ImplicitIntegrator(Point* a_points, size_t a_pointCount, const Constraint* a_constraints, size_t a_constraintCount);
+
+	/// @brief Advances the points by a single backward euler step
+	/// @param a_deltaTime Step length; can be much larger than the explicit integrators allow
+	/// @param a_stiffness Spring stiffness of the stretch constraints
+	/// @param a_damping Fraction of the velocity that is kept during the step
+	/// @return Number of conjugate gradient iterations that were needed
+	size_t step(float a_deltaTime, float a_stiffness, float a_damping);
+
+private:
+	//one float array per axis
+	typedef std::vector<float> Buffer[3];
+
+	//a spring that affects a point, along with the point on the other end
+	struct SpringRef
+	{
+		size_t m_spring;
+		size_t m_other;
+		float m_sign;
+	};
+
+	Point* m_points;
+	size_t m_pointCount;
+
+	//springs by point index
+	std::vector<size_t> m_springPoints1;
+	std::vector<size_t> m_springPoints2;
+	std::vector<float> m_restLengths;
+
+	//springs per point in compressed row form, so every product can be gathered in parallel without write conflicts
+	std::vector<size_t> m_springRefStarts;
+	std::vector<SpringRef> m_springRefs;
+
+	//per point state
+	Buffer m_positions;
+	Buffer m_velocities;
+	std::vector<float> m_masses;
+	std::vector<unsigned char> m_free;
+
+	//per spring force on its first point and symmetric force jacobian (xx, xy, xz, yy, yz, zz)
+	Buffer m_springForces;
+	std::vector<float> m_jacobians[6];
+
+	//inverse of the 3x3 diagonal block of the system per point
+	std::vector<glm::mat3> m_preconditioner;
+
+	//conjugate gradient buffers
+	Buffer m_solution;
+	Buffer m_residual;
+	Buffer m_preconditioned;
+	Buffer m_direction;
+	Buffer m_product;
+
+	void computeSprings(float a_stiffness);
+	void computeRightHandSide(float a_deltaTime);
+	size_t solve(float a_sqrDeltaTime);
+
+	//a_target = (M + h^2 * K) * a_source, with the rows and columns of pinned points filtered out
+	void multiply(float a_sqrDeltaTime, const Buffer& a_source, Buffer& a_target)const;
+	void precondition(const Buffer& a_source, Buffer& a_target)const;
+	double dot(const Buffer& a_first, const Buffer& a_second)const;
+};
@@ -1,8 +1,9 @@
 #include "Point.h"
-#include <glad/glad.h>
+#include "DebugDrawBatch.h"
 
 glm::vec3 Point::s_gravity(0.f, -9.8f, 0.f);
 glm::vec3 Point::s_globalForces(0.f, 0.f, 0.f);
+size_t Point::s_pinRevision = 0;
 
 Point::Point(const glm::vec3& a_initialPos, const glm::vec3& a_initialForce, float a_mass)
     : m_pos(a_initialPos)
@@ -32,6 +33,16 @@ float Point::getInvMass()const
     return m_invMass;
 }
 
+float Point::getMass()const
+{
+    return m_mass;
+}
+
+size_t Point::getPinRevision()
+{
+    return s_pinRevision;
+}
+
 void Point::addForce(const glm::vec3& a_toAdd)
 {
     m_force += a_toAdd;
@@ -52,76 +63,36 @@ void Point::resetPrevious()
     m_previousPos = m_pos;
 }
 
+void Point::scaleVelocity(float a_scale)
+{
+    m_previousPos = m_pos - ((m_pos - m_previousPos) * a_scale);
+}
+
 void Point::pin()
 {
     m_invMass = 0;
+    s_pinRevision++;
 }
 
 void Point::unpin()
 {
     m_invMass = 1.f / m_mass;
+    s_pinRevision++;
 }
 
-void Point::move(float a_deltaTime)
-{
-    if (m_invMass > 0.00001f)
-    {
-        glm::vec3 newPos = (m_pos * 1.99f) - (m_previousPos * 0.99f) + (m_force + s_globalForces) * a_deltaTime * a_deltaTime * m_invMass + s_gravity * a_deltaTime * a_deltaTime;
-        m_previousPos = m_pos;
-        m_pos = newPos;
-    }
-}
-
-void Point::draw(const Camera& a_camera)const
-{
-
-    float positional_data[216] = {
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f,-1.0f, 1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f, 1.0f, 0.f, 1.f, 0.f,
-    1.0f, 1.0f,-1.0f,  0.f, 1.f, 0.f,
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f,-1.0f, 0.f, 1.f, 0.f,
-    1.0f,-1.0f, 1.0f,  0.f, 1.f, 0.f,
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    1.0f,-1.0f,-1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f,-1.0f,  0.f, 1.f, 0.f,
-    1.0f,-1.0f,-1.0f,  0.f, 1.f, 0.f,
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f, 1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f,-1.0f, 0.f, 1.f, 0.f,
-    1.0f,-1.0f, 1.0f,  0.f, 1.f, 0.f,
-    -1.0f,-1.0f, 1.0f, 0.f, 1.f, 0.f,
-    -1.0f,-1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f, 1.0f, 0.f, 1.f, 0.f,
-    -1.0f,-1.0f, 1.0f, 0.f, 1.f, 0.f,
-    1.0f,-1.0f, 1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f, 1.0f,  0.f, 1.f, 0.f,
-    1.0f,-1.0f,-1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f,-1.0f,  0.f, 1.f, 0.f,
-    1.0f,-1.0f,-1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f, 1.0f,  0.f, 1.f, 0.f,
-    1.0f,-1.0f, 1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f, 1.0f,  0.f, 1.f, 0.f,
-    1.0f, 1.0f,-1.0f,  0.f, 1.f, 0.f,
-    -1.0f, 1.0f,-1.0f, 0.f, 1.f, 0.f,
-    1.0f, 1.0f, 1.0f,  0.f, 1.f, 0.f,
-    -1.0f, 1.0f,-1.0f, 0.f, 1.f, 0.f,
-    -1.0f, 1.0f, 1.0f, 0.f, 1.f, 0.f,
-    1.0f, 1.0f, 1.0f,  0.f, 1.f, 0.f,
-    -1.0f, 1.0f, 1.0f, 0.f, 1.f, 0.f,
-    1.0f,-1.0f, 1.0f,  0.f, 1.f, 0.f
-    };
-
-    for (size_t k = 0; k < 36; k++)
-    {
-        size_t base = k * 6;
-        for (size_t axis = 0; axis < 3; axis++)
-        {
-            positional_data[base + axis] = m_pos[axis] + positional_data[base + axis] * 0.125f * 0.75f;
-        }
-    }
-
-    drawData(a_camera, GL_TRIANGLES, sizeof(positional_data), positional_data, 36);
+void Point::move(float a_deltaTime, float a_damping)
+{
+    glm::vec3 newPos = (m_pos * (1.f + a_damping)) - (m_previousPos * a_damping) + (m_force + s_globalForces) * a_deltaTime * a_deltaTime * m_invMass + s_gravity * a_deltaTime * a_deltaTime;
+    m_previousPos = m_pos;
+    m_pos = newPos;
+}
+
+void Point::undoMove()
+{
+    m_pos = m_previousPos;
+}
+
+void Point::draw(DebugDrawBatch& a_batch)const
+{
+    a_batch.addCube(m_pos, 0.125f * 0.75f, glm::vec3(0.f, 1.f, 0.f));
 }
@@ -8,6 +8,9 @@ public:
     static glm::vec3 s_gravity;
     static glm::vec3 s_globalForces;
 
+    //fraction of the velocity that is kept every 1/60 s step
+    static constexpr float DEFAULT_DAMPING = 0.99f;
+
     Point(const glm::vec3& a_initialPos, const glm::vec3& a_initialForce, float a_mass);
 
     Point() = default;
@@ -19,20 +22,32 @@ public:
     const glm::vec3& getPreviousPos()const;
     const glm::vec3& getForce()const;
     float getInvMass()const;
+    float getMass()const;
+
+    //incremented whenever any point is pinned or unpinned, so solvers know when to rebuild pin dependent data
+    static size_t getPinRevision();
 
     void addForce(const glm::vec3& a_toAdd);
     void setForce(const glm::vec3& a_newForce);
 
     void setPos(const glm::vec3& a_newPos);
     void resetPrevious();
+    //rescales the implicit verlet velocity, used when the step length changes
+    void scaleVelocity(float a_scale);
     void pin();
     void unpin();
 
-    void move(float a_deltaTime);
+    //verlet step; moves pinned points too, the cloth puts those back with undoMove
+    void move(float a_deltaTime, float a_damping = DEFAULT_DAMPING);
+    //returns the point to where it was before the last move, at rest
+    void undoMove();
 
-    void draw(const Camera& a_camera)const;
+    //adds a cube at the point to the batch
+    void draw(DebugDrawBatch& a_batch)const;
 
 private:
+    static size_t s_pinRevision;
+
     glm::vec3 m_pos;
     glm::vec3 m_previousPos;
     glm::vec3 m_force;
@@ -0,0 +1,294 @@
+#include "ProjectiveDynamics.h"
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include "Point.h"
+#include "Constraint.h"
+
+namespace
+{
+	constexpr size_t NOT_AN_UNKNOWN = std::numeric_limits<size_t>::max();
+
+	//number of grid points below which a region is not dissected any further
+	constexpr size_t DISSECTION_LEAF_SIZE = 16;
+
+	//number of step lengths a factor is kept for
+	constexpr size_t MAX_CACHED_FACTORS = 4;
+
+	//orders the region [a_minX, a_maxX) x [a_minY, a_maxY) so that both halves come before the separator between them
+	void dissect(size_t a_minX, size_t a_maxX, size_t a_minY, size_t a_maxY, size_t a_dimY, std::vector<size_t>& a_target)
+	{
+		const size_t width = a_maxX - a_minX;
+		const size_t height = a_maxY - a_minY;
+		if (width == 0 || height == 0)
+		{
+			return;
+		}
+		if (width * height <= DISSECTION_LEAF_SIZE)
+		{
+			for (size_t x = a_minX; x < a_maxX; x++)
+			{
+				for (size_t y = a_minY; y < a_maxY; y++)
+				{
+					a_target.push_back(x * a_dimY + y);
+				}
+			}
+			return;
+		}
+
+		if (width >= height)
+		{
+			const size_t separator = a_minX + width / 2;
+			dissect(a_minX, separator, a_minY, a_maxY, a_dimY, a_target);
+			dissect(separator + 1, a_maxX, a_minY, a_maxY, a_dimY, a_target);
+			for (size_t y = a_minY; y < a_maxY; y++)
+			{
+				a_target.push_back(separator * a_dimY + y);
+			}
+		}
+		else
+		{
+			const size_t separator = a_minY + height / 2;
+			dissect(a_minX, a_maxX, a_minY, separator, a_dimY, a_target);
+			dissect(a_minX, a_maxX, separator + 1, a_maxY, a_dimY, a_target);
+			for (size_t x = a_minX; x < a_maxX; x++)
+			{
+				a_target.push_back(x * a_dimY + separator);
+			}
+		}
+	}
+}
+
+ProjectiveDynamics::ProjectiveDynamics(const glm::vec<2, size_t>& a_gridSize, Point* a_points, size_t a_pointCount, const Constraint* a_constraints, size_t a_constraintCount)
+	: m_gridSize(a_gridSize)
+	, m_points(a_points)
+	, m_pointCount(a_pointCount)
+	, m_stiffness(0.f)
+	, m_pinRevision(0)
+	, m_hasStructure(false)
+	, m_currentFactor(0)
+{
+	m_springs.reserve(a_constraintCount);
+	for (size_t k = 0; k < a_constraintCount; k++)
+	{
+		auto& constraint = a_constraints[k];
+		m_springs.push_back(Spring{
+			static_cast<size_t>(&constraint.getPoint1() - m_points),
+			static_cast<size_t>(&constraint.getPoint2() - m_points),
+			constraint.getRestLength()
+		});
+	}
+	m_projections.resize(m_springs.size());
+}
+
+void ProjectiveDynamics::prepare(float a_deltaTime, float a_stiffness, size_t a_pinRevision)
+{
+	if (!m_hasStructure || a_stiffness != m_stiffness || a_pinRevision != m_pinRevision)
+	{
+		m_pinRevision = a_pinRevision;
+		rebuildStructure(a_stiffness);
+	}
+
+	for (size_t k = 0; k < m_factors.size(); k++)
+	{
+		if (m_factors[k].m_deltaTime == a_deltaTime)
+		{
+			m_currentFactor = k;
+			return;
+		}
+	}
+
+	//adaptive substeps alternate between a few step lengths, so a handful of factors covers them
+	if (m_factors.size() >= MAX_CACHED_FACTORS)
+	{
+		m_factors.erase(m_factors.begin());
+	}
+	addFactor(a_deltaTime);
+	m_currentFactor = m_factors.size() - 1;
+}
+
+void ProjectiveDynamics::rebuildStructure(float a_stiffness)
+{
+	m_stiffness = a_stiffness;
+	m_hasStructure = true;
+	m_factors.clear();
+
+	//pinned points are known, so only the free points are unknowns
+	m_pointUnknowns.assign(m_pointCount, NOT_AN_UNKNOWN);
+	m_unknownPoints.clear();
+	for (size_t k = 0; k < m_pointCount; k++)
+	{
+		if (m_points[k].getInvMass() != 0.f)
+		{
+			m_pointUnknowns[k] = m_unknownPoints.size();
+			m_unknownPoints.push_back(k);
+		}
+	}
+	const size_t unknownCount = m_unknownPoints.size();
+
+	//stiffness part of the system matrix sum(w * A^T * A), lower triangle only
+	m_stiffnessEntries.clear();
+	m_stiffnessEntries.reserve(m_springs.size() * 3);
+	std::vector<size_t> refCounts(unknownCount + 1, 0);
+	for (auto& spring : m_springs)
+	{
+		const size_t unknown1 = m_pointUnknowns[spring.m_point1];
+		const size_t unknown2 = m_pointUnknowns[spring.m_point2];
+		if (unknown1 != NOT_AN_UNKNOWN)
+		{
+			m_stiffnessEntries.push_back({ unknown1, unknown1, a_stiffness });
+			refCounts[unknown1 + 1]++;
+		}
+		if (unknown2 != NOT_AN_UNKNOWN)
+		{
+			m_stiffnessEntries.push_back({ unknown2, unknown2, a_stiffness });
+			refCounts[unknown2 + 1]++;
+		}
+		if (unknown1 != NOT_AN_UNKNOWN && unknown2 != NOT_AN_UNKNOWN)
+		{
+			m_stiffnessEntries.push_back({ std::max(unknown1, unknown2), std::min(unknown1, unknown2), -static_cast<double>(a_stiffness) });
+		}
+	}
+
+	//springs per unknown
+	for (size_t k = 0; k < unknownCount; k++)
+	{
+		refCounts[k + 1] += refCounts[k];
+	}
+	m_springRefStarts = refCounts;
+	m_springRefs.resize(m_springRefStarts.back());
+	for (size_t k = 0; k < m_springs.size(); k++)
+	{
+		const size_t unknown1 = m_pointUnknowns[m_springs[k].m_point1];
+		const size_t unknown2 = m_pointUnknowns[m_springs[k].m_point2];
+		if (unknown1 != NOT_AN_UNKNOWN)
+		{
+			m_springRefs[refCounts[unknown1]++] = SpringRef{ k, 1.f };
+		}
+		if (unknown2 != NOT_AN_UNKNOWN)
+		{
+			m_springRefs[refCounts[unknown2]++] = SpringRef{ k, -1.f };
+		}
+	}
+
+	//the grid ordering is filtered down to the unknowns
+	m_ordering.clear();
+	m_ordering.reserve(unknownCount);
+	for (size_t point : computeOrdering())
+	{
+		if (m_pointUnknowns[point] != NOT_AN_UNKNOWN)
+		{
+			m_ordering.push_back(m_pointUnknowns[point]);
+		}
+	}
+
+	m_predictions.resize(unknownCount);
+	for (size_t axis = 0; axis < 3; axis++)
+	{
+		m_rightHandSides[axis].resize(unknownCount);
+		m_work[axis].resize(unknownCount);
+	}
+}
+
+void ProjectiveDynamics::addFactor(float a_deltaTime)
+{
+	const size_t unknownCount = m_unknownPoints.size();
+	m_factors.emplace_back();
+	auto& factor = m_factors.back();
+	factor.m_deltaTime = a_deltaTime;
+
+	//system matrix M / h^2 + sum(w * A^T * A)
+	std::vector<SparseCholesky::Entry> entries;
+	entries.reserve(unknownCount + m_stiffnessEntries.size());
+	const double invSqrDeltaTime = 1.0 / (static_cast<double>(a_deltaTime) * a_deltaTime);
+	factor.m_inertiaWeights.resize(unknownCount);
+	for (size_t k = 0; k < unknownCount; k++)
+	{
+		factor.m_inertiaWeights[k] = m_points[m_unknownPoints[k]].getMass() * invSqrDeltaTime;
+		entries.push_back({ k, k, factor.m_inertiaWeights[k] });
+	}
+	entries.insert(entries.end(), m_stiffnessEntries.begin(), m_stiffnessEntries.end());
+
+	if (!factor.m_cholesky.factorize(unknownCount, entries, m_ordering))
+	{
+		printf("Projective dynamics could not factor the system for a step of %f\n", a_deltaTime);
+	}
+}
+
+void ProjectiveDynamics::solve(size_t a_iterations)
+{
+	if (m_factors.empty() || !m_factors[m_currentFactor].m_cholesky.isFactorized())
+	{
+		return;
+	}
+	const auto& factor = m_factors[m_currentFactor];
+
+	const int unknownCount = static_cast<int>(m_unknownPoints.size());
+	const int springCount = static_cast<int>(m_springs.size());
+	for (int k = 0; k < unknownCount; k++)
+	{
+		m_predictions[k] = m_points[m_unknownPoints[k]].getPos();
+	}
+
+	for (size_t iteration = 0; iteration < a_iterations; iteration++)
+	{
+		//local step; projects every spring onto its rest length
+		#pragma omp parallel for
+		for (int k = 0; k < springCount; k++)
+		{
+			const auto& spring = m_springs[k];
+			const glm::vec3 delta = m_points[spring.m_point1].getPos() - m_points[spring.m_point2].getPos();
+			const float length = glm::length(delta);
+			m_projections[k] = length > 0.f ? delta * (spring.m_restLength / length) : delta;
+		}
+
+		//gathers the right hand side M / h^2 * s + sum(w * A^T * p) per unknown
+		#pragma omp parallel for
+		for (int k = 0; k < unknownCount; k++)
+		{
+			glm::dvec3 rightHandSide = glm::dvec3(m_predictions[k]) * factor.m_inertiaWeights[k];
+			for (size_t ref = m_springRefStarts[k]; ref < m_springRefStarts[k + 1]; ref++)
+			{
+				const auto& springRef = m_springRefs[ref];
+				const auto& spring = m_springs[springRef.m_spring];
+				rightHandSide += glm::dvec3(m_projections[springRef.m_spring] * springRef.m_sign) * static_cast<double>(m_stiffness);
+
+				//pinned neighbours are known, so they move to the right hand side
+				const size_t other = springRef.m_sign > 0.f ? spring.m_point2 : spring.m_point1;
+				if (m_pointUnknowns[other] == NOT_AN_UNKNOWN)
+				{
+					rightHandSide += glm::dvec3(m_points[other].getPos()) * static_cast<double>(m_stiffness);
+				}
+			}
+			for (size_t axis = 0; axis < 3; axis++)
+			{
+				m_rightHandSides[axis][k] = rightHandSide[static_cast<glm::length_t>(axis)];
+			}
+		}
+
+		//global step; one back-substitution per axis
+		#pragma omp parallel for
+		for (int axis = 0; axis < 3; axis++)
+		{
+			factor.m_cholesky.solve(m_rightHandSides[axis].data(), m_work[axis].data());
+		}
+
+		for (int k = 0; k < unknownCount; k++)
+		{
+			m_points[m_unknownPoints[k]].setPos(glm::vec3(
+				static_cast<float>(m_rightHandSides[0][k]),
+				static_cast<float>(m_rightHandSides[1][k]),
+				static_cast<float>(m_rightHandSides[2][k])
+			));
+		}
+	}
+}
+
+std::vector<size_t> ProjectiveDynamics::computeOrdering()const
+{
+	std::vector<size_t> ordering;
+	ordering.reserve(m_pointCount);
+	dissect(0, m_gridSize.x, 0, m_gridSize.y, m_gridSize.y, ordering);
+	return ordering;
+}
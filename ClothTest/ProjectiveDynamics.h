@@ -0,0 +1,89 @@
+#pragma once
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/detail/type_vec2.hpp>
+#include "SparseCholesky.h"
+
+class Point;
+class Constraint;
+
+//local/global projective dynamics solver for the stretch constraints of a grid cloth
+//the constant system matrix is factored once, after which every iteration is a parallel local projection and a back-substitution
+class ProjectiveDynamics
+{
+public:
+	ProjectiveDynamics(const glm::vec<2, size_t>& a_gridSize, Point* a_points, size_t a_pointCount, const Constraint* a_constraints, size_t a_constraintCount);
+
+	//selects the factor for the given settings, factoring the system matrix only for a step length that is not cached yet
+	//a_pinRevision identifies the set of pinned points of the cloth; a change in it or the stiffness drops every cached factor
+	void prepare(float a_deltaTime, float a_stiffness, size_t a_pinRevision);
+
+	//solves the constraints, assuming the points currently hold their inertial prediction; does nothing if the selected factor failed
+	void solve(size_t a_iterations);
+
+private:
+	//constraint between two points, by index
+	struct Spring
+	{
+		size_t m_point1;
+		size_t m_point2;
+		float m_restLength;
+	};
+
+	//a spring that affects an unknown; the sign is positive for the first point of the spring
+	struct SpringRef
+	{
+		size_t m_spring;
+		float m_sign;
+	};
+
+	glm::vec<2, size_t> m_gridSize;
+	Point* m_points;
+	size_t m_pointCount;
+	std::vector<Spring> m_springs;
+
+	//a factored system matrix for one step length; a failed factorization is kept as well, so it is not retried every step
+	struct Factor
+	{
+		float m_deltaTime;
+		//mass / step length squared per unknown
+		std::vector<double> m_inertiaWeights;
+		SparseCholesky m_cholesky;
+	};
+
+	//settings the cached factors were computed with
+	float m_stiffness;
+	size_t m_pinRevision;
+	bool m_hasStructure;
+
+	//mapping between points and the unknowns of the system; pinned points are not part of the system
+	std::vector<size_t> m_pointUnknowns;
+	std::vector<size_t> m_unknownPoints;
+
+	//springs per unknown in compressed row form, so the right hand side can be gathered in parallel
+	std::vector<size_t> m_springRefStarts;
+	std::vector<SpringRef> m_springRefs;
+
+	//stiffness part of the system matrix and elimination order of the unknowns, shared by every step length
+	std::vector<SparseCholesky::Entry> m_stiffnessEntries;
+	std::vector<size_t> m_ordering;
+
+	//factors by step length, oldest first, and the one used by solve
+	std::vector<Factor> m_factors;
+	size_t m_currentFactor;
+
+	//per iteration buffers
+	std::vector<glm::vec3> m_predictions;
+	std::vector<glm::vec3> m_projections;
+	std::vector<double> m_rightHandSides[3];
+	std::vector<double> m_work[3];
+
+	//maps the points to unknowns and builds everything that does not depend on the step length
+	void rebuildStructure(float a_stiffness);
+
+	//factors the system matrix for the given step length into a new cached factor
+	void addFactor(float a_deltaTime);
+
+	//nested dissection order of the unknowns, keeping the fill of the factor low
+	std::vector<size_t> computeOrdering()const;
+};
@@ -1,6 +1,11 @@
 #include "Shader.h"
 #include <glad/glad.h>
+#include "GLState.h"
 #include "Texture.h"
+#include "Camera.h"
+
+GLuint Shader::s_cameraBuffer = 0;
+glm::mat4 Shader::s_cameraViewProjection;
 
 Shader::Shader(const std::string& a_vertexSource, const std::string& a_fragmentSource)
     : m_shaderProgram(0)
@@ -25,13 +30,61 @@ Shader::~Shader()
 {
     if (m_shaderProgram)
     {
-        glDeleteProgram(m_shaderProgram);
+        GLState::deleteProgram(m_shaderProgram);
     }
 }
 
 void Shader::bind()
 {
-    glUseProgram(m_shaderProgram);
+    GLState::useProgram(m_shaderProgram);
+}
+
+void Shader::setCamera(const Camera& a_camera)
+{
+    //std140 lays out the three matrices back to back
+    const glm::mat4 matrices[3] = { a_camera.getView() * a_camera.getProjection(), a_camera.getView(), a_camera.getProjection() };
+    if (s_cameraBuffer && matrices[0] == s_cameraViewProjection)
+    {
+        return;
+    }
+    s_cameraViewProjection = matrices[0];
+    if (!s_cameraBuffer)
+    {
+        glGenBuffers(1, &s_cameraBuffer);
+        GLState::bindBuffer(GL_UNIFORM_BUFFER, s_cameraBuffer);
+        glBufferData(GL_UNIFORM_BUFFER, sizeof(matrices), matrices, GL_DYNAMIC_DRAW);
+        GLState::bindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, s_cameraBuffer);
+        return;
+    }
+    GLState::bindBuffer(GL_UNIFORM_BUFFER, s_cameraBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(matrices), matrices);
+}
+
+Shader::Uniform Shader::getUniform(const std::string& a_name)
+{
+    Uniform uniform;
+    uniform.m_location = static_cast<GLint>(getUniformLocation(a_name));
+    return uniform;
+}
+
+void Shader::setUniform(Uniform a_uniform, const int a_value)
+{
+    glUniform1i(a_uniform.m_location, a_value);
+}
+
+void Shader::setUniform(Uniform a_uniform, const bool a_value)
+{
+    glUniform1i(a_uniform.m_location, a_value ? 1 : 0);
+}
+
+void Shader::setUniform(Uniform a_uniform, const glm::ivec2& a_value)
+{
+    glUniform2i(a_uniform.m_location, a_value.x, a_value.y);
+}
+
+void Shader::setUniform(Uniform a_uniform, const glm::vec3& a_value)
+{
+    glUniform3f(a_uniform.m_location, a_value.x, a_value.y, a_value.z);
 }
 
 void Shader::setUniform(const std::string& a_name, const float a_value)
@@ -58,6 +111,12 @@ void Shader::setUniform(const std::string& a_name, const glm::vec2& a_value)
     glUniform2f(getUniformLocation(a_name), a_value.x, a_value.y);
 }
 
+void Shader::setUniform(const std::string& a_name, const glm::ivec2& a_value)
+{
+    bind();
+    glUniform2i(getUniformLocation(a_name), a_value.x, a_value.y);
+}
+
 void Shader::setUniform(const std::string& a_name, const glm::vec3& a_value)
 {
     bind();
@@ -164,5 +223,12 @@ void Shader::createShaderProgram(const std::string& a_vertexSource, const std::s
     //deletes shaders
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
+
+    //every shader that declares the camera block reads it from the same binding point
+    const GLuint cameraBlock = glGetUniformBlockIndex(m_shaderProgram, "Camera");
+    if (cameraBlock != GL_INVALID_INDEX)
+    {
+        glUniformBlockBinding(m_shaderProgram, cameraBlock, CAMERA_BLOCK_BINDING);
+    }
 }
 
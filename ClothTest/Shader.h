@@ -8,10 +8,21 @@
 #include <glm/mat4x4.hpp>
 
 typedef unsigned int GLuint;
+typedef int GLint;
 
 class Shader
 {
 public:
+    //binding point of the uniform block holding the camera matrices, declared in shaders as
+    //layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };
+    static constexpr GLuint CAMERA_BLOCK_BINDING = 0;
+
+    //handle of a uniform, resolved once so that setting it needs neither a string nor a map lookup
+    struct Uniform
+    {
+        GLint m_location = -1;
+    };
+
     /// @brief Constructor
     /// @param a_vertexSource Source code string of the vertex shader
     /// @param a_fragmentSource Source code string of the fragment shader
@@ -35,6 +46,36 @@ public:
     /// @brief Binds the shader to be the currently used shader
     void bind();
 
+    /// @brief Makes the camera uniform block shared by every shader hold the matrices of the camera
+    /// The buffer is only written when the matrices differ from the last ones, so every draw can call this cheaply
+    /// @param a_camera The camera to draw with
+    static void setCamera(const class Camera& a_camera);
+
+    /// @brief Resolves the handle of a uniform
+    /// @param a_name The name of the uniform
+    /// @return The handle, which stays valid for the lifetime of the shader
+    Uniform getUniform(const std::string& a_name);
+
+    /// @brief Sets an int uniform by handle; the shader has to be bound
+    /// @param a_uniform The handle of the uniform
+    /// @param a_value The new value of the uniform
+    void setUniform(Uniform a_uniform, const int a_value);
+
+    /// @brief Sets a bool uniform by handle; the shader has to be bound
+    /// @param a_uniform The handle of the uniform
+    /// @param a_value The new value of the uniform
+    void setUniform(Uniform a_uniform, const bool a_value);
+
+    /// @brief Sets an ivec2 uniform by handle; the shader has to be bound
+    /// @param a_uniform The handle of the uniform
+    /// @param a_value The new value of the uniform
+    void setUniform(Uniform a_uniform, const glm::ivec2& a_value);
+
+    /// @brief Sets a vec3 uniform by handle; the shader has to be bound
+    /// @param a_uniform The handle of the uniform
+    /// @param a_value The new value of the uniform
+    void setUniform(Uniform a_uniform, const glm::vec3& a_value);
+
     /// @brief Sets a float uniform
     /// @param a_name The name of the uniform
     /// @param a_value The new value of the uniform
@@ -55,6 +96,11 @@ public:
     /// @param a_value The new value of the uniform
     void setUniform(const std::string& a_name, const glm::vec2& a_value);
 
+    /// @brief Sets an ivec2 uniform
+    /// @param a_name The name of the uniform
+    /// @param a_value The new value of the uniform
+    void setUniform(const std::string& a_name, const glm::ivec2& a_value);
+
     /// @brief Sets a vec3 uniform
     /// @param a_name The name of the uniform
     /// @param a_value The new value of the uniform
@@ -87,6 +133,10 @@ private:
     //a map for storing uniform locations
     std::map<std::string, GLuint> m_uniformLocations;
 
+    //buffer behind the camera uniform block, and the view projection matrix it holds
+    static GLuint s_cameraBuffer;
+    static glm::mat4 s_cameraViewProjection;
+
     //returns the location of the uniform of the given name
     GLuint getUniformLocation(const std::string& a_name);
 
@@ -0,0 +1,270 @@
+#include "SleepTracker.h"
+#include <cmath>
+#include <algorithm>
+#include <glm/geometric.hpp>
+#include "Point.h"
+#include "Constraint.h"
+#include "Sphere.h"
+
+namespace
+{
+	//appends [a_begin, a_end) to the ranges, extending the last range if they touch
+	void appendRange(std::vector<SleepTracker::Range>& a_ranges, size_t a_begin, size_t a_end)
+	{
+		if (!a_ranges.empty() && a_ranges.back().m_end == a_begin)
+		{
+			a_ranges.back().m_end = a_end;
+		}
+		else
+		{
+			a_ranges.push_back(SleepTracker::Range{ a_begin, a_end });
+		}
+	}
+}
+
+SleepTracker::SleepTracker(const glm::vec<2, size_t>& a_gridSize, Point* a_points, const Constraint* a_constraints, size_t a_constraintCount, float a_particleDistance)
+	: m_gridSize(a_gridSize)
+	, m_tileCount((a_gridSize.x + TILE_SIZE - 1) / TILE_SIZE, (a_gridSize.y + TILE_SIZE - 1) / TILE_SIZE)
+	, m_points(a_points)
+	, m_constraints(a_constraints)
+	, m_constraintCount(a_constraintCount)
+	, m_sqrSleepThreshold(SLEEP_THRESHOLD * SLEEP_THRESHOLD * a_particleDistance * a_particleDistance)
+	, m_padding(a_particleDistance)
+	, m_activePointCount(0)
+	, m_activeTileCount(0)
+	, m_revision(0)
+{
+	for (size_t x = 0; x < m_tileCount.x; x++)
+	{
+		for (size_t y = 0; y < m_tileCount.y; y++)
+		{
+			Tile tile;
+			tile.m_min = glm::vec<2, size_t>(x * TILE_SIZE, y * TILE_SIZE);
+			tile.m_max = glm::min(tile.m_min + glm::vec<2, size_t>(TILE_SIZE, TILE_SIZE), m_gridSize);
+			tile.m_awake = true;
+			tile.m_moved = false;
+			tile.m_restingSteps = 0;
+			m_tiles.push_back(tile);
+		}
+	}
+
+	const size_t pointCount = m_gridSize.x * m_gridSize.y;
+	m_pointAwake.assign(pointCount, 1);
+	m_referencePositions.resize(pointCount);
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		m_referencePositions[k] = m_points[k].getPos();
+	}
+	m_constraintAwake.resize(m_constraintCount);
+	rebuildActive();
+}
+
+void SleepTracker::wake(const std::vector<Sphere*>& a_colliders, const std::vector<size_t>& a_pinnedPoints)
+{
+	for (auto& range : m_awakePointRanges)
+	{
+		for (size_t point = range.m_begin; point < range.m_end; point++)
+		{
+			m_referencePositions[point] = m_points[point].getPos();
+		}
+	}
+
+	bool changed = false;
+	//pinned points can be moved anywhere in a tile, such as by a kinematic target
+	for (size_t pinned : a_pinnedPoints)
+	{
+		if (!m_pointAwake[pinned] && hasMoved(pinned))
+		{
+			setAwake(getTileIndex(pinned), true);
+			changed = true;
+		}
+	}
+
+	for (size_t tileIndex = 0; tileIndex < m_tiles.size(); tileIndex++)
+	{
+		auto& tile = m_tiles[tileIndex];
+		if (tile.m_awake)
+		{
+			continue;
+		}
+
+		//small corrections from awake neighbours are tolerated until they add up
+		bool moved = false;
+		for (size_t x = tile.m_min.x; x < tile.m_max.x && !moved; x++)
+		{
+			//only the first and last column are entirely on the border, unless something else moved a point of the tile
+			const bool fullColumn = tile.m_moved || x == tile.m_min.x || x + 1 == tile.m_max.x;
+			const size_t stride = fullColumn ? 1 : std::max<size_t>(tile.m_max.y - tile.m_min.y - 1, 1);
+			for (size_t y = tile.m_min.y; y < tile.m_max.y && !moved; y += stride)
+			{
+				moved = hasMoved((x * m_gridSize.y) + y);
+			}
+		}
+		tile.m_moved = false;
+
+		bool nearCollider = false;
+		for (auto& collider : a_colliders)
+		{
+			if (tile.m_bounds.intersectsSphere(collider->getPos(), collider->getRadius()))
+			{
+				nearCollider = true;
+				break;
+			}
+		}
+		if (moved || nearCollider)
+		{
+			setAwake(tileIndex, true);
+			changed = true;
+		}
+	}
+	if (changed)
+	{
+		rebuildActive();
+	}
+}
+
+void SleepTracker::update()
+{
+	std::vector<size_t> toWake;
+	bool changed = false;
+	for (size_t tileIndex = 0; tileIndex < m_tiles.size(); tileIndex++)
+	{
+		auto& tile = m_tiles[tileIndex];
+		if (!tile.m_awake)
+		{
+			continue;
+		}
+
+		float maxSqrDisplacement = 0.f;
+		for (size_t x = tile.m_min.x; x < tile.m_max.x; x++)
+		{
+			for (size_t y = tile.m_min.y; y < tile.m_max.y; y++)
+			{
+				const size_t point = (x * m_gridSize.y) + y;
+				const glm::vec3 displacement = m_points[point].getPos() - m_referencePositions[point];
+				maxSqrDisplacement = std::max(maxSqrDisplacement, glm::dot(displacement, displacement));
+			}
+		}
+
+		if (maxSqrDisplacement > m_sqrSleepThreshold)
+		{
+			//a moving tile keeps its neighbours from sleeping through the motion it passes on
+			tile.m_restingSteps = 0;
+			toWake.push_back(tileIndex);
+		}
+		else if (++tile.m_restingSteps >= SLEEP_STEPS)
+		{
+			setAwake(tileIndex, false);
+			changed = true;
+		}
+	}
+
+	for (size_t tileIndex : toWake)
+	{
+		const size_t tileX = tileIndex / m_tileCount.y;
+		const size_t tileY = tileIndex % m_tileCount.y;
+		for (size_t x = tileX - std::min<size_t>(tileX, 1); x <= std::min(tileX + 1, m_tileCount.x - 1); x++)
+		{
+			for (size_t y = tileY - std::min<size_t>(tileY, 1); y <= std::min(tileY + 1, m_tileCount.y - 1); y++)
+			{
+				const size_t neighbour = (x * m_tileCount.y) + y;
+				m_tiles[neighbour].m_restingSteps = 0;
+				if (!m_tiles[neighbour].m_awake)
+				{
+					setAwake(neighbour, true);
+					changed = true;
+				}
+			}
+		}
+	}
+
+	if (changed)
+	{
+		rebuildActive();
+	}
+}
+
+void SleepTracker::markMoved(size_t a_point)
+{
+	m_tiles[getTileIndex(a_point)].m_moved = true;
+}
+
+size_t SleepTracker::getTileIndex(size_t a_point)const
+{
+	return ((a_point / m_gridSize.y) / TILE_SIZE) * m_tileCount.y + ((a_point % m_gridSize.y) / TILE_SIZE);
+}
+
+bool SleepTracker::hasMoved(size_t a_point)const
+{
+	const glm::vec3 displacement = m_points[a_point].getPos() - m_referencePositions[a_point];
+	return glm::dot(displacement, displacement) > m_sqrSleepThreshold;
+}
+
+void SleepTracker::setAwake(size_t a_tile, bool a_awake)
+{
+	auto& tile = m_tiles[a_tile];
+	tile.m_awake = a_awake;
+	tile.m_moved = false;
+	tile.m_restingSteps = 0;
+	tile.m_bounds = BoundingBox(glm::vec3(INFINITY), glm::vec3(-INFINITY));
+	for (size_t x = tile.m_min.x; x < tile.m_max.x; x++)
+	{
+		for (size_t y = tile.m_min.y; y < tile.m_max.y; y++)
+		{
+			const size_t point = (x * m_gridSize.y) + y;
+			m_pointAwake[point] = a_awake ? 1 : 0;
+			if (a_awake)
+			{
+				continue;
+			}
+
+			//sleeping points lose their velocity, so they stay put once woken up again
+			auto& sleeper = m_points[point];
+			sleeper.resetPrevious();
+			m_referencePositions[point] = sleeper.getPos();
+			tile.m_bounds.m_min = glm::min(tile.m_bounds.m_min, sleeper.getPos() - glm::vec3(m_padding));
+			tile.m_bounds.m_max = glm::max(tile.m_bounds.m_max, sleeper.getPos() + glm::vec3(m_padding));
+		}
+	}
+}
+
+void SleepTracker::rebuildActive()
+{
+	m_revision++;
+	m_activePointCount = 0;
+	m_activeTileCount = 0;
+	for (auto& tile : m_tiles)
+	{
+		if (tile.m_awake)
+		{
+			m_activeTileCount++;
+			m_activePointCount += (tile.m_max.x - tile.m_min.x) * (tile.m_max.y - tile.m_min.y);
+		}
+	}
+
+	//points are stored column by column, so every column crosses a column of tiles
+	m_awakePointRanges.clear();
+	for (size_t x = 0; x < m_gridSize.x; x++)
+	{
+		const size_t columnStart = x * m_gridSize.y;
+		for (size_t tileY = 0; tileY < m_tileCount.y; tileY++)
+		{
+			const auto& tile = m_tiles[((x / TILE_SIZE) * m_tileCount.y) + tileY];
+			if (tile.m_awake)
+			{
+				appendRange(m_awakePointRanges, columnStart + tile.m_min.y, columnStart + tile.m_max.y);
+			}
+		}
+	}
+
+	m_awakeConstraintRanges.clear();
+	for (size_t k = 0; k < m_constraintCount; k++)
+	{
+		const auto& constraint = m_constraints[k];
+		m_constraintAwake[k] = m_pointAwake[&constraint.getPoint1() - m_points] | m_pointAwake[&constraint.getPoint2() - m_points];
+		if (m_constraintAwake[k])
+		{
+			appendRange(m_awakeConstraintRanges, k, k + 1);
+		}
+	}
+}
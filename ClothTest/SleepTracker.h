@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <glm/vec3.hpp>
+#include <glm/detail/type_vec2.hpp>
+#include "BoundingBox.h"
+
+class Point;
+class Constraint;
+class Sphere;
+
+//tracks which tiles of a grid cloth are at rest, so the solver can skip them entirely
+class SleepTracker
+{
+public:
+	//width and height of a tile in grid points
+	static constexpr size_t TILE_SIZE = 8;
+	//largest displacement during a step, relative to the particle distance, at which a point counts as resting
+	static constexpr float SLEEP_THRESHOLD = 0.005f;
+	//number of steps a tile has to rest before it falls asleep
+	static constexpr size_t SLEEP_STEPS = 30;
+
+	//range of indices [m_begin, m_end)
+	struct Range
+	{
+		size_t m_begin;
+		size_t m_end;
+	};
+
+	/// @brief Creates the tiles; every tile starts awake
+	/// @param a_gridSize Size of the grid; points are stored column by column
+	/// @param a_points Points of the grid
+	/// @param a_constraints Constraints between the points
+	/// @param a_constraintCount Number of constraints
+	/// @param a_particleDistance Rest distance between neighbouring points
+	SleepTracker(const glm::vec<2, size_t>& a_gridSize, Point* a_points, const Constraint* a_constraints, size_t a_constraintCount, float a_particleDistance);
+
+	//wakes the tiles that were moved from outside the solver, such as by a moving pin, or that a collider comes close to
+	//the solver only reaches into a sleeping tile through its border, so only the border, pinned and marked points are tested
+	//also records where the awake points start the step; call before the step
+	void wake(const std::vector<Sphere*>& a_colliders, const std::vector<size_t>& a_pinnedPoints);
+
+	//puts tiles that rested long enough to sleep, and wakes the neighbours of tiles that are moving; call after the step
+	void update();
+
+	//makes the next wake test every point of the tile of a sleeping point that was moved other than through a constraint
+	void markMoved(size_t a_point);
+
+	bool isPointAwake(size_t a_point)const { return m_pointAwake[a_point] != 0; };
+	//a constraint is awake while either of its points is
+	bool isConstraintAwake(size_t a_constraint)const { return m_constraintAwake[a_constraint] != 0; };
+	bool isAnyAwake()const { return m_activeTileCount > 0; };
+
+	//awake points and constraints as ascending ranges of indices, so the solvers can walk them without testing every index
+	const std::vector<Range>& getAwakePointRanges()const { return m_awakePointRanges; };
+	const std::vector<Range>& getAwakeConstraintRanges()const { return m_awakeConstraintRanges; };
+	//changes whenever a tile falls asleep or wakes up
+	size_t getRevision()const { return m_revision; };
+
+	size_t getActivePointCount()const { return m_activePointCount; };
+	size_t getSleepingPointCount()const { return m_pointAwake.size() - m_activePointCount; };
+	size_t getActiveTileCount()const { return m_activeTileCount; };
+	size_t getSleepingTileCount()const { return m_tiles.size() - m_activeTileCount; };
+
+private:
+	struct Tile
+	{
+		//range of grid points [m_min, m_max)
+		glm::vec<2, size_t> m_min;
+		glm::vec<2, size_t> m_max;
+		bool m_awake;
+		//set while asleep when a point was moved other than through the border constraints
+		bool m_moved;
+		size_t m_restingSteps;
+		//bounds of the points, padded by the particle distance, while asleep
+		BoundingBox m_bounds;
+	};
+
+	glm::vec<2, size_t> m_gridSize;
+	glm::vec<2, size_t> m_tileCount;
+	Point* m_points;
+	const Constraint* m_constraints;
+	size_t m_constraintCount;
+	float m_sqrSleepThreshold;
+	float m_padding;
+
+	std::vector<Tile> m_tiles;
+	std::vector<unsigned char> m_pointAwake;
+	std::vector<unsigned char> m_constraintAwake;
+	std::vector<Range> m_awakePointRanges;
+	std::vector<Range> m_awakeConstraintRanges;
+	//start of the step for awake points, position they fell asleep at for sleeping points
+	std::vector<glm::vec3> m_referencePositions;
+
+	size_t m_activePointCount;
+	size_t m_activeTileCount;
+	size_t m_revision;
+
+	size_t getTileIndex(size_t a_point)const;
+	bool hasMoved(size_t a_point)const;
+	void setAwake(size_t a_tile, bool a_awake);
+	//recounts the awake points and rebuilds the awake constraints and ranges
+	void rebuildActive();
+};
@@ -0,0 +1,202 @@
+#include "SparseCholesky.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
+
+namespace
+{
+	constexpr size_t NONE = std::numeric_limits<size_t>::max();
+}
+
+SparseCholesky::SparseCholesky()
+	: m_size(0)
+	, m_factorized(false)
+{}
+
+bool SparseCholesky::factorize(size_t a_size, const std::vector<Entry>& a_entries, const std::vector<size_t>& a_ordering)
+{
+	m_size = a_size;
+	m_factorized = false;
+
+	//sets up the permutation
+	m_permutation.resize(m_size);
+	m_inversePermutation.resize(m_size);
+	for (size_t k = 0; k < m_size; k++)
+	{
+		m_permutation[k] = a_ordering.empty() ? k : a_ordering[k];
+		m_inversePermutation[m_permutation[k]] = k;
+	}
+
+	//builds the upper triangle of the permuted matrix in compressed column form
+	std::vector<size_t> starts(m_size + 1, 0);
+	for (auto& entry : a_entries)
+	{
+		const size_t row = m_inversePermutation[entry.m_row];
+		const size_t column = m_inversePermutation[entry.m_column];
+		starts[std::max(row, column) + 1]++;
+	}
+	for (size_t k = 0; k < m_size; k++)
+	{
+		starts[k + 1] += starts[k];
+	}
+	std::vector<size_t> rows(starts.back());
+	std::vector<double> values(starts.back());
+	{
+		std::vector<size_t> next(starts.begin(), starts.end() - 1);
+		for (auto& entry : a_entries)
+		{
+			const size_t row = m_inversePermutation[entry.m_row];
+			const size_t column = m_inversePermutation[entry.m_column];
+			const size_t target = next[std::max(row, column)]++;
+			rows[target] = std::min(row, column);
+			values[target] = entry.m_value;
+		}
+	}
+
+	//elimination tree
+	std::vector<size_t> parent(m_size, NONE);
+	{
+		std::vector<size_t> ancestor(m_size, NONE);
+		for (size_t k = 0; k < m_size; k++)
+		{
+			for (size_t p = starts[k]; p < starts[k + 1]; p++)
+			{
+				size_t i = rows[p];
+				while (i != NONE && i < k)
+				{
+					const size_t next = ancestor[i];
+					ancestor[i] = k;
+					if (next == NONE)
+					{
+						parent[i] = k;
+					}
+					i = next;
+				}
+			}
+		}
+	}
+
+	//symbolic factorization; counts the entries of every column of L
+	std::vector<size_t> stack(m_size);
+	std::vector<size_t> marks(m_size, NONE);
+	std::vector<size_t> counts(m_size, 1);
+	for (size_t k = 0; k < m_size; k++)
+	{
+		for (size_t top = reachRow(k, starts, rows, parent, stack, marks); top < m_size; top++)
+		{
+			counts[stack[top]]++;
+		}
+	}
+	m_columnStarts.assign(m_size + 1, 0);
+	for (size_t k = 0; k < m_size; k++)
+	{
+		m_columnStarts[k + 1] = m_columnStarts[k] + counts[k];
+	}
+	m_rowIndices.assign(m_columnStarts.back(), 0);
+	m_values.assign(m_columnStarts.back(), 0.0);
+
+	//numeric factorization, computing L one row at a time
+	std::fill(marks.begin(), marks.end(), NONE);
+	std::vector<size_t> nextFree(m_columnStarts.begin(), m_columnStarts.end() - 1);
+	std::vector<double> row(m_size, 0.0);
+	for (size_t k = 0; k < m_size; k++)
+	{
+		size_t top = reachRow(k, starts, rows, parent, stack, marks);
+		row[k] = 0.0;
+		for (size_t p = starts[k]; p < starts[k + 1]; p++)
+		{
+			row[rows[p]] += values[p];
+		}
+		double diagonal = row[k];
+		row[k] = 0.0;
+		for (; top < m_size; top++)
+		{
+			const size_t i = stack[top];
+			const double value = row[i] / m_values[m_columnStarts[i]];
+			row[i] = 0.0;
+			for (size_t p = m_columnStarts[i] + 1; p < nextFree[i]; p++)
+			{
+				row[m_rowIndices[p]] -= m_values[p] * value;
+			}
+			diagonal -= value * value;
+			const size_t target = nextFree[i]++;
+			m_rowIndices[target] = k;
+			m_values[target] = value;
+		}
+		if (diagonal <= 0.0)
+		{
+			printf("Sparse cholesky failed; matrix is not positive definite!\n");
+			return false;
+		}
+		const size_t target = nextFree[k]++;
+		m_rowIndices[target] = k;
+		m_values[target] = sqrt(diagonal);
+	}
+
+	m_factorized = true;
+	return true;
+}
+
+void SparseCholesky::solve(double* a_values, double* a_work)const
+{
+	for (size_t k = 0; k < m_size; k++)
+	{
+		a_work[k] = a_values[m_permutation[k]];
+	}
+
+	//forward substitution with L
+	for (size_t j = 0; j < m_size; j++)
+	{
+		a_work[j] /= m_values[m_columnStarts[j]];
+		const double value = a_work[j];
+		for (size_t p = m_columnStarts[j] + 1; p < m_columnStarts[j + 1]; p++)
+		{
+			a_work[m_rowIndices[p]] -= m_values[p] * value;
+		}
+	}
+
+	//backward substitution with L^T
+	for (size_t j = m_size; j-- > 0;)
+	{
+		double value = a_work[j];
+		for (size_t p = m_columnStarts[j] + 1; p < m_columnStarts[j + 1]; p++)
+		{
+			value -= m_values[p] * a_work[m_rowIndices[p]];
+		}
+		a_work[j] = value / m_values[m_columnStarts[j]];
+	}
+
+	for (size_t k = 0; k < m_size; k++)
+	{
+		a_values[m_permutation[k]] = a_work[k];
+	}
+}
+
+size_t SparseCholesky::reachRow(size_t a_row, const std::vector<size_t>& a_starts, const std::vector<size_t>& a_rows, const std::vector<size_t>& a_parent, std::vector<size_t>& a_stack, std::vector<size_t>& a_marks)
+{
+	const size_t size = a_stack.size();
+	size_t top = size;
+	a_marks[a_row] = a_row;
+	for (size_t p = a_starts[a_row]; p < a_starts[a_row + 1]; p++)
+	{
+		size_t i = a_rows[p];
+		if (i > a_row)
+		{
+			continue;
+		}
+
+		//walks up the tree until an already visited node, then pushes the path in topological order
+		size_t length = 0;
+		for (; a_marks[i] != a_row; i = a_parent[i])
+		{
+			a_stack[length++] = i;
+			a_marks[i] = a_row;
+		}
+		while (length > 0)
+		{
+			a_stack[--top] = a_stack[--length];
+		}
+	}
+	return top;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <vector>
+#include <cstddef>
+
+//self-contained sparse cholesky factorization (L * L^T) of a symmetric positive definite matrix
+//the factor is computed once, after which every solve is a forward and a backward substitution
+class SparseCholesky
+{
+public:
+	//a single matrix entry; entries at the same position are summed
+	struct Entry
+	{
+		size_t m_row;
+		size_t m_column;
+		double m_value;
+	};
+
+	SparseCholesky();
+
+	/// @brief Factors the matrix
+	/// @param a_size Number of rows/columns of the matrix
+	/// @param a_entries Entries of either the lower or the upper triangle
+	/// @param a_ordering Elimination order; a_ordering[k] is the row eliminated k-th, empty for the natural order
+	/// @return False if the matrix is not positive definite
+	bool factorize(size_t a_size, const std::vector<Entry>& a_entries, const std::vector<size_t>& a_ordering);
+
+	/// @brief Solves A * x = b in place
+	/// @param a_values Right hand side on input, solution on output
+	/// @param a_work Scratch buffer of at least getSize() values
+	void solve(double* a_values, double* a_work)const;
+
+	bool isFactorized()const { return m_factorized; };
+	size_t getSize()const { return m_size; };
+	size_t getNonZeroCount()const { return m_values.size(); };
+
+private:
+	size_t m_size;
+	bool m_factorized;
+
+	//permutation from elimination order to row and back
+	std::vector<size_t> m_permutation;
+	std::vector<size_t> m_inversePermutation;
+
+	//factor L in compressed column form, the diagonal is the first entry of every column
+	std::vector<size_t> m_columnStarts;
+	std::vector<size_t> m_rowIndices;
+	std::vector<double> m_values;
+
+	//computes the pattern of row a_row of L by walking the elimination tree; returns the start of the pattern in a_stack
+	static size_t reachRow(size_t a_row, const std::vector<size_t>& a_starts, const std::vector<size_t>& a_rows, const std::vector<size_t>& a_parent, std::vector<size_t>& a_stack, std::vector<size_t>& a_marks);
+};
@@ -1,33 +1,65 @@
 #include "Sphere.h"
+#include <vector>
+#include <algorithm>
 #include <glad/glad.h>
-#include <glm/ext/matrix_transform.hpp>
+#include "GLState.h"
 #include "SphereGen/SphereGenerator.h"
 #include "Shader.h"
 #include "VertexLayout.h"
 #include "Camera.h"
+#include "StreamingBuffer.h"
 
 Shader* Sphere::s_shader = nullptr;
 VertexLayout* Sphere::s_vertexLayout = nullptr;
+VertexLayout* Sphere::s_instanceLayout = nullptr;
+std::map<std::tuple<int, int, bool>, Sphere::Mesh*> Sphere::s_meshes;
 
-Sphere::Sphere(float a_radius)
-	: m_buffer(0)
-	, m_indexBuffer(0)
-	, m_indexCount(0)
+//instances the stream of a mesh holds before it grows for the first time
+static constexpr size_t INITIAL_INSTANCE_CAPACITY = 64;
+
+struct Sphere::Mesh
+{
+	GLuint m_buffer = 0;
+	GLuint m_indexBuffer = 0;
+	size_t m_indexCount = 0;
+	std::vector<const Sphere*> m_spheres;
+
+	//positions and radii of the spheres, rewritten every draw
+	StreamingBuffer* m_instanceStream = nullptr;
+	size_t m_instanceCapacity = 0;
+};
+
+Sphere::Sphere(float a_radius, int a_sectorCount, int a_stackCount, bool a_smooth)
+	: m_mesh(nullptr)
 	, m_radius(a_radius)
 	, m_pos(0, 0, 0)
 {
-	SphereGenerator generator(a_radius);
+	createRenderingResources();
 
-	glGenBuffers(1, &m_buffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	glBufferData(GL_ARRAY_BUFFER, generator.getInterleavedVertexSize(), generator.getInterleavedVertices(), GL_STATIC_DRAW);
+	const auto key = std::make_tuple(a_sectorCount, a_stackCount, a_smooth);
+	auto iter = s_meshes.find(key);
+	if (iter != s_meshes.end())
+	{
+		m_mesh = iter->second;
+	}
+	else
+	{
+		SphereGenerator generator(1.f, a_sectorCount, a_stackCount, a_smooth);
+		m_mesh = new Mesh();
 
-	glGenBuffers(1, &m_indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, generator.getIndexSize(), generator.getIndices(), GL_STATIC_DRAW);
-	m_indexCount = generator.getIndexCount();
+		glGenBuffers(1, &m_mesh->m_buffer);
+		GLState::bindBuffer(GL_ARRAY_BUFFER, m_mesh->m_buffer);
+		glBufferData(GL_ARRAY_BUFFER, generator.getInterleavedVertexSize(), generator.getInterleavedVertices(), GL_STATIC_DRAW);
 
-	createRenderingResources();
+		glGenBuffers(1, &m_mesh->m_indexBuffer);
+		VertexLayout::unbind();
+		GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_mesh->m_indexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, generator.getIndexSize(), generator.getIndices(), GL_STATIC_DRAW);
+		m_mesh->m_indexCount = generator.getIndexCount();
+
+		s_meshes.insert({ key, m_mesh });
+	}
+	m_mesh->m_spheres.push_back(this);
 }
 
 void Sphere::createRenderingResources()
@@ -37,19 +69,21 @@ void Sphere::createRenderingResources()
 		s_shader = new Shader(
 			"#version 330 core\n"
 			""
-			"in vec3 a_pos;"
-			"in vec3 a_normal;"
-			"in vec2 a_texCoord;"
+			"layout(location = 0) in vec3 a_pos;"
+			"layout(location = 1) in vec3 a_normal;"
+			"layout(location = 2) in vec2 a_texCoord;"
+			"layout(location = 3) in vec4 a_centerRadius;"
 			""
-			"uniform mat4 u_mvp;"
+			"layout(std140) uniform Camera { mat4 u_vp; mat4 u_view; mat4 u_projection; };"
 			""
 			"out vec3 v_worldPos;"
 			"out vec3 v_normal;"
 			""
 			"void main()"
 			"{"
-			"	gl_Position = u_mvp * vec4(a_pos, 1.0);"
-			"	v_worldPos = a_pos;"
+			"	vec3 localPos = a_pos * a_centerRadius.w;"
+			"	gl_Position = u_vp * vec4(localPos + a_centerRadius.xyz, 1.0);"
+			"	v_worldPos = localPos;"
 			"	v_normal = vec3(a_normal.x, -a_normal.y, a_normal.z);"
 			"}"
 
@@ -79,20 +113,58 @@ void Sphere::createRenderingResources()
 		s_vertexLayout->addFloatComponent(3); //pos
 		s_vertexLayout->addFloatComponent(3); //normal
 		s_vertexLayout->addFloatComponent(2); //texcoord
+
+		s_instanceLayout = new VertexLayout();
+		s_instanceLayout->addFloatComponent(4); //center and radius
+		s_instanceLayout->setDivisor(1);
 	}
 }
 
-void Sphere::draw(const class Camera& a_camera)const
+void Sphere::drawAll(const Camera& a_camera)
 {
-	s_shader->bind();
-	s_shader->setUniform("u_mvp", a_camera.getView() * a_camera.getProjection() * glm::translate(glm::identity<glm::mat4x4>(), m_pos));
-
-	glBindBuffer(GL_ARRAY_BUFFER, m_buffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
-
-	s_vertexLayout->bind();
+	if (s_meshes.empty())
+	{
+		return;
+	}
 
-	glDrawElements(GL_TRIANGLES, m_indexCount, GL_UNSIGNED_INT, (void*)0);
+	Shader::setCamera(a_camera);
+	s_shader->bind();
+	for (auto& entry : s_meshes)
+	{
+		Mesh& mesh = *entry.second;
+		const size_t count = mesh.m_spheres.size();
+
+		//the stream doubles until every sphere fits in a region
+		if (!mesh.m_instanceStream || count > mesh.m_instanceCapacity)
+		{
+			if (mesh.m_instanceCapacity == 0)
+			{
+				mesh.m_instanceCapacity = INITIAL_INSTANCE_CAPACITY;
+			}
+			while (mesh.m_instanceCapacity < count)
+			{
+				mesh.m_instanceCapacity *= 2;
+			}
+			if (mesh.m_instanceStream)
+			{
+				s_vertexLayout->releaseVertexArrays(mesh.m_instanceStream->getBuffer());
+				delete mesh.m_instanceStream;
+			}
+			mesh.m_instanceStream = new StreamingBuffer(mesh.m_instanceCapacity * sizeof(Instance));
+		}
+
+		Instance* instances = static_cast<Instance*>(mesh.m_instanceStream->beginWrite());
+		for (size_t k = 0; k < count; k++)
+		{
+			instances[k] = { mesh.m_spheres[k]->m_pos, mesh.m_spheres[k]->m_radius };
+		}
+		const size_t region = mesh.m_instanceStream->endWrite();
+
+		//the instance attributes start at the region, since instanced draws have no base instance before GL 4.2
+		s_vertexLayout->bindInstanced(mesh.m_buffer, mesh.m_indexBuffer, *s_instanceLayout, mesh.m_instanceStream->getBuffer(), region * mesh.m_instanceCapacity * sizeof(Instance));
+		glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(mesh.m_indexCount), GL_UNSIGNED_INT, (void*)0, static_cast<GLsizei>(count));
+		mesh.m_instanceStream->fence();
+	}
 }
 
 float Sphere::getRadius()const
@@ -112,6 +184,30 @@ void Sphere::setPos(const glm::vec3& a_pos)
 
 Sphere::~Sphere()
 {
-	glDeleteBuffers(1, &m_buffer);
-	glDeleteBuffers(1, &m_indexBuffer);
-}
\ No newline at end of file
+	auto& spheres = m_mesh->m_spheres;
+	spheres.erase(std::find(spheres.begin(), spheres.end(), this));
+	if (!spheres.empty())
+	{
+		return;
+	}
+
+	//last sphere using the mesh
+	for (auto iter = s_meshes.begin(); iter != s_meshes.end(); iter++)
+	{
+		if (iter->second == m_mesh)
+		{
+			s_meshes.erase(iter);
+			break;
+		}
+	}
+	s_vertexLayout->releaseVertexArrays(m_mesh->m_buffer);
+	if (m_mesh->m_instanceStream)
+	{
+		s_vertexLayout->releaseVertexArrays(m_mesh->m_instanceStream->getBuffer());
+		delete m_mesh->m_instanceStream;
+	}
+	GLState::deleteBuffer(m_mesh->m_buffer);
+	GLState::deleteBuffer(m_mesh->m_indexBuffer);
+	delete m_mesh;
+	m_mesh = nullptr;
+}
@@ -1,4 +1,6 @@
 #pragma once
+#include <map>
+#include <tuple>
 #include <glm/vec3.hpp>
 
 typedef unsigned int GLuint;
@@ -6,24 +8,38 @@ typedef unsigned int GLuint;
 class Sphere
 {
 public:
-	Sphere(float a_radius);
+	//the mesh is a unit sphere shared by every sphere with the same sectors, stacks and smoothing, scaled by the radius when drawn
+	Sphere(float a_radius, int a_sectorCount = 36, int a_stackCount = 18, bool a_smooth = true);
+	Sphere(const Sphere&) = delete;
+	Sphere& operator=(const Sphere&) = delete;
 
 	float getRadius()const;
 	const glm::vec3& getPos()const;
-	
+
 	void setPos(const glm::vec3& a_pos);
 
-	void draw(const class Camera& a_camera)const;
+	//draws every existing sphere, with a single instanced draw call per mesh
+	static void drawAll(const class Camera& a_camera);
 
 	~Sphere();
 
 private:
+	//shared mesh along with the spheres using it, defined in the source file
+	struct Mesh;
+
+	struct Instance
+	{
+		glm::vec3 m_pos;
+		float m_radius;
+	};
+
 	static class Shader* s_shader;
 	static class VertexLayout* s_vertexLayout;
+	static class VertexLayout* s_instanceLayout;
+	//meshes by sector count, stack count and smoothing; a mesh is deleted along with the last sphere using it
+	static std::map<std::tuple<int, int, bool>, Mesh*> s_meshes;
 
-	GLuint m_buffer;
-	GLuint m_indexBuffer;
-	size_t m_indexCount;
+	Mesh* m_mesh;
 
 	float m_radius;
 	glm::vec3 m_pos;
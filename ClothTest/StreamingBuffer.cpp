@@ -0,0 +1,98 @@
+#include "StreamingBuffer.h"
+#include <cstdio>
+#include <glad/glad.h>
+#include "GLState.h"
+
+StreamingBuffer::StreamingBuffer(size_t a_regionSize, size_t a_regionCount)
+	: m_buffer(0)
+	, m_regionSize(a_regionSize)
+	, m_regionCount(a_regionCount)
+	, m_currentRegion(0)
+	, m_mapped(nullptr)
+	, m_fences(nullptr)
+{
+	glGenBuffers(1, &m_buffer);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (GLAD_GL_VERSION_4_4)
+	{
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		const GLsizeiptr size = static_cast<GLsizeiptr>(m_regionSize * m_regionCount);
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		m_mapped = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+		m_fences = new GLsync[m_regionCount]();
+	}
+	else
+	{
+		m_regionCount = 1;
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_regionSize), nullptr, GL_STREAM_DRAW);
+		printf("Persistent mapping is unavailable, streaming by orphaning\n");
+	}
+}
+
+StreamingBuffer::~StreamingBuffer()
+{
+	if (m_fences)
+	{
+		for (size_t k = 0; k < m_regionCount; k++)
+		{
+			if (m_fences[k])
+			{
+				glDeleteSync(m_fences[k]);
+			}
+		}
+		delete[] m_fences;
+	}
+	if (m_mapped)
+	{
+		GLState::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	if (m_buffer)
+	{
+		GLState::deleteBuffer(m_buffer);
+	}
+}
+
+void* StreamingBuffer::beginWrite()
+{
+	m_currentRegion = (m_currentRegion + 1) % m_regionCount;
+	if (!m_mapped)
+	{
+		//orphaning hands the old storage to the driver, so the mapping never waits on draws that still use it
+		GLState::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(m_regionSize), nullptr, GL_STREAM_DRAW);
+		return glMapBufferRange(GL_ARRAY_BUFFER, 0, static_cast<GLsizeiptr>(m_regionSize), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	}
+
+	GLsync& fence = m_fences[m_currentRegion];
+	if (fence)
+	{
+		//with three regions the gpu is normally long done with this one, so this rarely waits
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED && result != GL_WAIT_FAILED)
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+	return m_mapped + (m_currentRegion * m_regionSize);
+}
+
+size_t StreamingBuffer::endWrite()
+{
+	GLState::bindBuffer(GL_ARRAY_BUFFER, m_buffer);
+	if (!m_mapped)
+	{
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+	}
+	return m_currentRegion;
+}
+
+void StreamingBuffer::fence()
+{
+	if (m_fences)
+	{
+		m_fences[m_currentRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
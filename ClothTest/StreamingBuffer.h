@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+
+typedef unsigned int GLuint;
+typedef struct __GLsync* GLsync;
+
+//vertex buffer that is rewritten every frame without reallocating
+//uses a ring of regions in one persistently mapped buffer, each guarded by a fence, so the cpu never writes to a region the gpu
+//still reads from; falls back to orphaning a single region when persistent mapping (GL 4.4) is not available
+class StreamingBuffer
+{
+public:
+	static constexpr size_t DEFAULT_REGION_COUNT = 3;
+
+	/// @brief Creates the buffer with storage for every region
+	/// @param a_regionSize Size of a single frame's data in bytes
+	/// @param a_regionCount Number of frames that can be in flight at once
+	StreamingBuffer(size_t a_regionSize, size_t a_regionCount = DEFAULT_REGION_COUNT);
+	StreamingBuffer(const StreamingBuffer&) = delete;
+	StreamingBuffer& operator=(const StreamingBuffer&) = delete;
+	~StreamingBuffer();
+
+	/// @brief Moves on to the next region, waiting for the gpu to finish reading it if needed
+	/// @return Pointer the data of this frame is written to, valid until endWrite
+	void* beginWrite();
+
+	/// @brief Finishes writing the region and binds the buffer to GL_ARRAY_BUFFER
+	/// @return Index of the region that was written, to be used as the base vertex (times the vertices per region) when drawing
+	size_t endWrite();
+
+	//guards the region that was just written until the draw calls issued so far are done; call after drawing from it
+	void fence();
+
+	GLuint getBuffer()const { return m_buffer; };
+	bool isPersistent()const { return m_mapped != nullptr; };
+
+private:
+	GLuint m_buffer;
+	size_t m_regionSize;
+	size_t m_regionCount;
+	size_t m_currentRegion;
+
+	//start of the persistent mapping, null when orphaning
+	unsigned char* m_mapped;
+	GLsync* m_fences;
+};
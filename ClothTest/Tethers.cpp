@@ -0,0 +1,100 @@
+#include "Tethers.h"
+#include <cmath>
+#include <limits>
+#include <glm/geometric.hpp>
+#include "Point.h"
+#include "SleepTracker.h"
+
+namespace
+{
+	constexpr size_t NO_ANCHOR = std::numeric_limits<size_t>::max();
+}
+
+Tethers::Tethers(const glm::vec<2, size_t>& a_gridSize, Point* a_points, float a_maxLength)
+	: m_gridSize(a_gridSize)
+	, m_points(a_points)
+	, m_maxLength(a_maxLength)
+	, m_pinRevision(0)
+{
+	rebuild();
+}
+
+void Tethers::solve(const SleepTracker* a_sleepTracker)
+{
+	if (m_pinRevision != Point::getPinRevision())
+	{
+		rebuild();
+	}
+
+	//every tether moves a different point, so they are solved as one parallel batch
+	const int tetherCount = static_cast<int>(m_tethers.size());
+	#pragma omp parallel for
+	for (int k = 0; k < tetherCount; k++)
+	{
+		const auto& tether = m_tethers[k];
+		if (a_sleepTracker && !a_sleepTracker->isPointAwake(tether.m_point))
+		{
+			continue;
+		}
+		auto& point = m_points[tether.m_point];
+		const auto& anchor = m_points[tether.m_anchor].getPos();
+		const glm::vec3 delta = point.getPos() - anchor;
+		const float sqrDst = glm::dot(delta, delta);
+		if (sqrDst > tether.m_maxLength * tether.m_maxLength)
+		{
+			point.setPos(anchor + delta * (tether.m_maxLength / sqrtf(sqrDst)));
+		}
+	}
+}
+
+void Tethers::rebuild()
+{
+	m_pinRevision = Point::getPinRevision();
+	m_tethers.clear();
+
+	const size_t pointCount = m_gridSize.x * m_gridSize.y;
+	std::vector<size_t> anchors(pointCount, NO_ANCHOR);
+	std::vector<size_t> distances(pointCount, 0);
+	std::vector<size_t> queue;
+	queue.reserve(pointCount);
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		if (m_points[k].getInvMass() == 0.f)
+		{
+			anchors[k] = k;
+			queue.push_back(k);
+		}
+	}
+
+	//every step along the grid is one structural constraint
+	for (size_t front = 0; front < queue.size(); front++)
+	{
+		const size_t current = queue[front];
+		const size_t x = current / m_gridSize.y;
+		const size_t y = current % m_gridSize.y;
+		const size_t neighbours[4] = {
+			x > 0 ? current - m_gridSize.y : NO_ANCHOR,
+			x + 1 < m_gridSize.x ? current + m_gridSize.y : NO_ANCHOR,
+			y > 0 ? current - 1 : NO_ANCHOR,
+			y + 1 < m_gridSize.y ? current + 1 : NO_ANCHOR
+		};
+		for (size_t neighbour : neighbours)
+		{
+			if (neighbour != NO_ANCHOR && anchors[neighbour] == NO_ANCHOR)
+			{
+				anchors[neighbour] = anchors[current];
+				distances[neighbour] = distances[current] + 1;
+				queue.push_back(neighbour);
+			}
+		}
+	}
+
+	//direct neighbours of an anchor are already bound by their structural constraint
+	for (size_t k = 0; k < pointCount; k++)
+	{
+		if (anchors[k] != NO_ANCHOR && distances[k] > 1)
+		{
+			m_tethers.push_back(Tether{ k, anchors[k], static_cast<float>(distances[k]) * m_maxLength });
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <vector>
+#include <glm/detail/type_vec2.hpp>
+
+class Point;
+class SleepTracker;
+
+//long range attachments from every free point of a grid cloth to its geodesically nearest pinned point
+//a tether only pulls when the point is further away than the cloth between them allows, bounding the stretch regardless of the iteration count
+class Tethers
+{
+public:
+	/// @brief Creates the tethers for the current set of pinned points
+	/// @param a_gridSize Size of the grid; points are stored column by column
+	/// @param a_points Points of the grid
+	/// @param a_maxLength Maximum length of a single structural constraint
+	Tethers(const glm::vec<2, size_t>& a_gridSize, Point* a_points, float a_maxLength);
+
+	//moves every free point back within reach of its anchor, skipping sleeping points if a sleep tracker is given
+	//the tethers are rebuilt first if any point was pinned or unpinned
+	void solve(const SleepTracker* a_sleepTracker);
+
+	size_t getTetherCount()const { return m_tethers.size(); };
+
+private:
+	struct Tether
+	{
+		size_t m_point;
+		size_t m_anchor;
+		float m_maxLength;
+	};
+
+	glm::vec<2, size_t> m_gridSize;
+	Point* m_points;
+	float m_maxLength;
+	size_t m_pinRevision;
+
+	std::vector<Tether> m_tethers;
+
+	//breadth first search over the grid from all pinned points at once
+	void rebuild();
+};
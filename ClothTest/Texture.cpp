@@ -1,5 +1,6 @@
 #include "Texture.h"
 #include <glad/glad.h>
+#include "GLState.h"
 #include <stb_image.h>
 #include "FrameBuffer.h"
 
@@ -7,7 +8,7 @@ Texture::Texture(const std::string& a_filename)
 	: m_texture(0)
 {
 	glGenTextures(1, &m_texture);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(0, GL_TEXTURE_2D, m_texture);
 
 	int width, height, channels;
 	unsigned char* data = stbi_load(a_filename.c_str(), &width, &height, &channels, 4);
@@ -22,7 +23,7 @@ Texture::Texture(const glm::vec<2, size_t>& a_size)
 	: m_texture(0)
 {
 	glGenTextures(1, &m_texture);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(0, GL_TEXTURE_2D, m_texture);
 
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, a_size.x, a_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
@@ -33,14 +34,13 @@ Texture::~Texture()
 {
 	if (m_texture)
 	{
-		glDeleteTextures(1, &m_texture);
+		GLState::deleteTexture(m_texture);
 	}
 }
 
 void Texture::bind(unsigned int a_slot)
 {
-	glActiveTexture(GL_TEXTURE0 + a_slot);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	GLState::bindTexture(a_slot, GL_TEXTURE_2D, m_texture);
 }
 
 void Texture::setAsFrameBufferTexture(FrameBuffer& a_frameBuffer, unsigned int a_attachment)
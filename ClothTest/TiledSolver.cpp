@@ -0,0 +1,127 @@
+#include "TiledSolver.h"
+#include <algorithm>
+#include "Point.h"
+#include "Constraint.h"
+#include "SleepTracker.h"
+
+namespace
+{
+	//copies the constraints that are awake, or all of them without a sleep tracker
+	void filterAwake(const std::vector<size_t>& a_constraints, const SleepTracker* a_sleepTracker, std::vector<size_t>& a_target)
+	{
+		a_target.clear();
+		for (size_t constraint : a_constraints)
+		{
+			if (!a_sleepTracker || a_sleepTracker->isConstraintAwake(constraint))
+			{
+				a_target.push_back(constraint);
+			}
+		}
+	}
+}
+
+TiledSolver::TiledSolver(const glm::vec<2, size_t>& a_gridSize, Point* a_points, Constraint* a_constraints, size_t a_constraintCount, size_t a_tileSize)
+	: m_gridSize(a_gridSize)
+	, m_tileSize(std::max<size_t>(a_tileSize, 2))
+	, m_tileCount((a_gridSize.x + m_tileSize - 1) / m_tileSize, (a_gridSize.y + m_tileSize - 1) / m_tileSize)
+	, m_constraints(a_constraints)
+{
+	m_tiles.resize(m_tileCount.x * m_tileCount.y);
+	m_tileResiduals.resize(m_tiles.size());
+	for (size_t k = 0; k < a_constraintCount; k++)
+	{
+		const size_t point1 = static_cast<size_t>(&a_constraints[k].getPoint1() - a_points);
+		const size_t point2 = static_cast<size_t>(&a_constraints[k].getPoint2() - a_points);
+		const size_t tileX1 = (point1 / m_gridSize.y) / m_tileSize;
+		const size_t tileY1 = (point1 % m_gridSize.y) / m_tileSize;
+		const size_t tileX2 = (point2 / m_gridSize.y) / m_tileSize;
+		const size_t tileY2 = (point2 % m_gridSize.y) / m_tileSize;
+		if (tileX1 != tileX2)
+		{
+			m_haloX.push_back(k);
+		}
+		else if (tileY1 != tileY2)
+		{
+			m_haloY.push_back(k);
+		}
+		else
+		{
+			m_tiles[(tileX1 * m_tileCount.y) + tileY1].push_back(k);
+		}
+	}
+	m_haloResiduals.resize(std::max(m_haloX.size(), m_haloY.size()));
+	m_awakeTiles.resize(m_tiles.size());
+	setAwakeConstraints(nullptr);
+}
+
+void TiledSolver::setAwakeConstraints(const SleepTracker* a_sleepTracker)
+{
+	for (size_t tile = 0; tile < m_tiles.size(); tile++)
+	{
+		filterAwake(m_tiles[tile], a_sleepTracker, m_awakeTiles[tile]);
+	}
+	filterAwake(m_haloX, a_sleepTracker, m_awakeHaloX);
+	filterAwake(m_haloY, a_sleepTracker, m_awakeHaloY);
+}
+
+float TiledSolver::solve(size_t a_innerIterations, float a_invSqrDeltaTime)
+{
+	const int tileCount = static_cast<int>(m_awakeTiles.size());
+	#pragma omp parallel for schedule(dynamic)
+	for (int tile = 0; tile < tileCount; tile++)
+	{
+		m_tileResiduals[tile] = solveBatch(m_awakeTiles[tile], a_invSqrDeltaTime);
+		for (size_t iteration = 1; iteration < a_innerIterations; iteration++)
+		{
+			solveBatch(m_awakeTiles[tile], a_invSqrDeltaTime);
+		}
+	}
+
+	float residual = 0.f;
+	for (float tileResidual : m_tileResiduals)
+	{
+		residual = std::max(residual, tileResidual);
+	}
+	residual = std::max(residual, solveHalo(m_awakeHaloX, a_invSqrDeltaTime));
+	residual = std::max(residual, solveHalo(m_awakeHaloY, a_invSqrDeltaTime));
+	return residual;
+}
+
+float TiledSolver::solveBatch(const std::vector<size_t>& a_constraints, float a_invSqrDeltaTime)
+{
+	float residual = 0.f;
+	if (a_invSqrDeltaTime > 0.f)
+	{
+		for (size_t constraint : a_constraints)
+		{
+			residual = std::max(residual, m_constraints[constraint].satisfyCompliant(a_invSqrDeltaTime));
+		}
+	}
+	else
+	{
+		for (size_t constraint : a_constraints)
+		{
+			residual = std::max(residual, m_constraints[constraint].satisfy());
+		}
+	}
+	return residual;
+}
+
+float TiledSolver::solveHalo(const std::vector<size_t>& a_constraints, float a_invSqrDeltaTime)
+{
+	//the halo constraints along one axis touch every point at most once, so they can all be solved at the same time
+	const int constraintCount = static_cast<int>(a_constraints.size());
+	#pragma omp parallel for
+	for (int k = 0; k < constraintCount; k++)
+	{
+		auto& constraint = m_constraints[a_constraints[k]];
+		m_haloResiduals[k] = a_invSqrDeltaTime > 0.f ? constraint.satisfyCompliant(a_invSqrDeltaTime) : constraint.satisfy();
+	}
+
+	float residual = 0.f;
+	for (int k = 0; k < constraintCount; k++)
+	{
+		residual = std::max(residual, m_haloResiduals[k]);
+	}
+	return residual;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <vector>
+#include <glm/detail/type_vec2.hpp>
+
+class Point;
+class Constraint;
+class SleepTracker;
+
+//solves the constraints of a grid cloth tile by tile, running several iterations on a tile while it is still in cache
+//tiles only touch their own points, so they are solved in parallel; the constraints between tiles form the halo and are solved afterwards
+class TiledSolver
+{
+public:
+	//a 16x16 tile of points and its constraints take up about 40KB, which stays within L1 or L2
+	static constexpr size_t DEFAULT_TILE_SIZE = 16;
+
+	/// @brief Assigns every constraint to a tile or to the halo
+	/// @param a_gridSize Size of the grid; points are stored column by column
+	/// @param a_points Points of the grid
+	/// @param a_constraints Constraints between the points
+	/// @param a_constraintCount Number of constraints
+	/// @param a_tileSize Width and height of a tile in grid points, at least 2
+	TiledSolver(const glm::vec<2, size_t>& a_gridSize, Point* a_points, Constraint* a_constraints, size_t a_constraintCount, size_t a_tileSize = DEFAULT_TILE_SIZE);
+
+	/// @brief Runs a_innerIterations passes over the constraints inside every tile, followed by a single pass over the halo
+	/// @param a_innerIterations Number of passes per tile
+	/// @param a_invSqrDeltaTime 1 / (substep length squared) for XPBD constraints, 0 for relaxation
+	/// @return Largest relative stretch seen in the first pass
+	float solve(size_t a_innerIterations, float a_invSqrDeltaTime);
+
+	//limits the solve to the constraints the sleep tracker considers awake, or lifts the limit for nullptr
+	//the selection holds until the next call, so it only needs to be set again when the tracker changes
+	void setAwakeConstraints(const SleepTracker* a_sleepTracker);
+
+	size_t getTileCount()const { return m_tiles.size(); };
+
+private:
+	glm::vec<2, size_t> m_gridSize;
+	size_t m_tileSize;
+	glm::vec<2, size_t> m_tileCount;
+	Constraint* m_constraints;
+
+	//constraints with both points inside the tile, per tile
+	std::vector<std::vector<size_t>> m_tiles;
+	//constraints that cross a border between tiles along x and along y; constraints within either set share no points
+	std::vector<size_t> m_haloX;
+	std::vector<size_t> m_haloY;
+
+	//the awake subset of the tiles and halos, which is what gets solved
+	std::vector<std::vector<size_t>> m_awakeTiles;
+	std::vector<size_t> m_awakeHaloX;
+	std::vector<size_t> m_awakeHaloY;
+
+	//largest relative stretch per tile and per halo constraint, since the reduction has to work with OpenMP 2.0
+	//both are sized once, so a solve does not allocate
+	std::vector<float> m_tileResiduals;
+	std::vector<float> m_haloResiduals;
+
+	float solveBatch(const std::vector<size_t>& a_constraints, float a_invSqrDeltaTime);
+	float solveHalo(const std::vector<size_t>& a_constraints, float a_invSqrDeltaTime);
+};
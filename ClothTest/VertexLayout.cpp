@@ -1,64 +1,171 @@
 #include "VertexLayout.h"
 #include <glad/glad.h>
+#include "GLState.h"
 
 //adds a char layout component
 void VertexLayout::addCharComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_BYTE, a_count, sizeof(char), a_normalized); //const GLenum a_type, const unsigned int a_count, const unsigned int a_typeSize, const bool a_normalized
+	m_components.emplace_back(GL_BYTE, a_count, a_count * sizeof(char), a_normalized); //const GLenum a_type, const unsigned int a_count, const unsigned int a_typeSize, const bool a_normalized
 	m_stride += a_count * sizeof(char);
 }
 
 //adds an int layout component
 void VertexLayout::addIntComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_INT, a_count, sizeof(int), a_normalized);
+	m_components.emplace_back(GL_INT, a_count, a_count * sizeof(int), a_normalized);
 	m_stride += a_count * sizeof(int);
 }
 
 //adds an unsigned char layout component
 void VertexLayout::addUCharComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_UNSIGNED_INT, a_count, sizeof(unsigned int), a_normalized);
-	m_stride += a_count * sizeof(unsigned int);
+	m_components.emplace_back(GL_UNSIGNED_BYTE, a_count, a_count * sizeof(unsigned char), a_normalized);
+	m_stride += a_count * sizeof(unsigned char);
 }
 
 //adds an unsigned int layout component
 void VertexLayout::addUIntComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_UNSIGNED_BYTE, a_count, sizeof(unsigned char), a_normalized);
-	m_stride += a_count * sizeof(unsigned char);
+	m_components.emplace_back(GL_UNSIGNED_INT, a_count, a_count * sizeof(unsigned int), a_normalized);
+	m_stride += a_count * sizeof(unsigned int);
+}
+
+//adds a short layout component
+void VertexLayout::addShortComponent(unsigned int a_count, bool a_normalized)
+{
+	m_components.emplace_back(GL_SHORT, a_count, a_count * sizeof(short), a_normalized);
+	m_stride += a_count * sizeof(short);
+}
+
+//adds an unsigned short layout component
+void VertexLayout::addUShortComponent(unsigned int a_count, bool a_normalized)
+{
+	m_components.emplace_back(GL_UNSIGNED_SHORT, a_count, a_count * sizeof(unsigned short), a_normalized);
+	m_stride += a_count * sizeof(unsigned short);
 }
 
 //adds a float layout component
 void VertexLayout::addFloatComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_FLOAT, a_count, sizeof(float), a_normalized);
+	m_components.emplace_back(GL_FLOAT, a_count, a_count * sizeof(float), a_normalized);
 	m_stride += a_count * sizeof(float);
 }
 
 //adds a double layout component
 void VertexLayout::addDoubleComponent(unsigned int a_count, bool a_normalized)
 {
-	m_components.emplace_back(GL_DOUBLE, a_count, sizeof(double), a_normalized);
+	m_components.emplace_back(GL_DOUBLE, a_count, a_count * sizeof(double), a_normalized);
 	m_stride += a_count * sizeof(double);
 }
 
+//adds a 2_10_10_10 packed layout component
+void VertexLayout::addPackedComponent(bool a_normalized)
+{
+	m_components.emplace_back(GL_INT_2_10_10_10_REV, 4, sizeof(unsigned int), a_normalized);
+	m_stride += sizeof(unsigned int);
+}
+
+//sets the instance divisor
+void VertexLayout::setDivisor(unsigned int a_divisor)
+{
+	m_divisor = a_divisor;
+}
+
 //returns stride
 unsigned int VertexLayout::getStride()const
 {
 	return m_stride;
 }
 
-//binds this layout
-void VertexLayout::bind()
+//binds the vertex array object for the buffers, building it if needed
+void VertexLayout::bind(GLuint a_vertexBuffer, GLuint a_indexBuffer, size_t a_offset)
+{
+	const auto key = std::make_tuple(a_vertexBuffer, a_indexBuffer, a_offset);
+	auto iter = m_vertexArrays.find(key);
+	if (iter != m_vertexArrays.end())
+	{
+		GLState::bindVertexArray(iter->second);
+		return;
+	}
+
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	GLState::bindVertexArray(vertexArray);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, a_vertexBuffer);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_indexBuffer);
+	specifyAttributes(a_offset);
+	m_vertexArrays.insert({ key, vertexArray });
+}
+
+//binds the vertex array object for the buffers and instance buffer, building it if needed
+void VertexLayout::bindInstanced(GLuint a_vertexBuffer, GLuint a_indexBuffer, const VertexLayout& a_instanceLayout, GLuint a_instanceBuffer, size_t a_instanceOffset)
+{
+	const auto key = std::make_tuple(a_vertexBuffer, a_indexBuffer, a_instanceBuffer, a_instanceOffset);
+	auto iter = m_instancedVertexArrays.find(key);
+	if (iter != m_instancedVertexArrays.end())
+	{
+		GLState::bindVertexArray(iter->second);
+		return;
+	}
+
+	GLuint vertexArray = 0;
+	glGenVertexArrays(1, &vertexArray);
+	GLState::bindVertexArray(vertexArray);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, a_vertexBuffer);
+	GLState::bindBuffer(GL_ELEMENT_ARRAY_BUFFER, a_indexBuffer);
+	specifyAttributes(0);
+	GLState::bindBuffer(GL_ARRAY_BUFFER, a_instanceBuffer);
+	a_instanceLayout.specifyAttributes(a_instanceOffset, static_cast<unsigned int>(m_components.size()));
+	m_instancedVertexArrays.insert({ key, vertexArray });
+}
+
+//deletes the vertex array objects of a buffer
+void VertexLayout::releaseVertexArrays(GLuint a_vertexBuffer)
+{
+	for (auto iter = m_vertexArrays.begin(); iter != m_vertexArrays.end();)
+	{
+		if (std::get<0>(iter->first) == a_vertexBuffer)
+		{
+			GLState::deleteVertexArray(iter->second);
+			iter = m_vertexArrays.erase(iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+	for (auto iter = m_instancedVertexArrays.begin(); iter != m_instancedVertexArrays.end();)
+	{
+		if (std::get<0>(iter->first) == a_vertexBuffer || std::get<2>(iter->first) == a_vertexBuffer)
+		{
+			GLState::deleteVertexArray(iter->second);
+			iter = m_instancedVertexArrays.erase(iter);
+		}
+		else
+		{
+			iter++;
+		}
+	}
+}
+
+//binds the default vertex array object
+void VertexLayout::unbind()
+{
+	GLState::bindVertexArray(0);
+}
+
+//sets up the attributes of the bound vertex array object
+void VertexLayout::specifyAttributes(size_t a_offset, unsigned int a_firstLocation)const
 {
-	glEnableVertexAttribArray(0);
-	size_t offset = 0;
+	size_t offset = a_offset;
 	for (unsigned int k = 0; k < m_components.size(); k++)
 	{
 		auto& comp = m_components[k];
-		glVertexAttribPointer(k, comp.count, GL_FLOAT, comp.normalized ? GL_TRUE : GL_FALSE, m_stride, reinterpret_cast<const void*>(offset));
-		glEnableVertexAttribArray(k);
-		offset += comp.typeSize * comp.count;
+		const unsigned int location = a_firstLocation + k;
+		//integer components are converted to floats, mapped to [0, 1] or [-1, 1] when normalized
+		glVertexAttribPointer(location, comp.count, comp.type, comp.normalized ? GL_TRUE : GL_FALSE, m_stride, reinterpret_cast<const void*>(offset));
+		glVertexAttribDivisor(location, m_divisor);
+		glEnableVertexAttribArray(location);
+		offset += comp.size;
 	}
 }
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 #include <vector>
+#include <map>
+#include <tuple>
 
 typedef unsigned int GLenum;
+typedef unsigned int GLuint;
 
 class VertexLayout
 {
@@ -11,9 +14,10 @@ private:
 	{
 		GLenum type;
 		unsigned int count;
-		size_t typeSize;
+		//size of the whole component in bytes
+		size_t size;
 		bool normalized;
-		LayoutComponent(const GLenum a_type, const unsigned int a_count, const size_t a_typeSize, const bool a_normalized) : type(a_type), count(a_count), typeSize(a_typeSize), normalized(a_normalized) {};
+		LayoutComponent(const GLenum a_type, const unsigned int a_count, const size_t a_size, const bool a_normalized) : type(a_type), count(a_count), size(a_size), normalized(a_normalized) {};
 	};
 
 	//bound layout
@@ -23,18 +27,49 @@ private:
 	unsigned int m_stride{ 0 };
 	std::vector<LayoutComponent> m_components;
 
+	//0 advances the attributes per vertex, N advances them once every N instances
+	unsigned int m_divisor{ 0 };
+
+	//vertex array objects built so far, by vertex buffer, index buffer and offset into the vertex buffer
+	std::map<std::tuple<GLuint, GLuint, size_t>, GLuint> m_vertexArrays;
+	//vertex array objects with instance attributes, by vertex buffer, index buffer, instance buffer and offset into the instance buffer
+	std::map<std::tuple<GLuint, GLuint, GLuint, size_t>, GLuint> m_instancedVertexArrays;
+
+	//specifies and enables the attributes for the buffer bound to GL_ARRAY_BUFFER, starting a_offset bytes into it
+	//the attributes take the locations from a_firstLocation onwards
+	void specifyAttributes(size_t a_offset, unsigned int a_firstLocation = 0)const;
+
 public:
 	//adds a layout component of the specified type
 	void addCharComponent(unsigned int a_count, bool a_normalized = false);
 	void addIntComponent(unsigned int a_count, bool a_normalized = false);
 	void addUCharComponent(unsigned int a_count, bool a_normalized = false);
 	void addUIntComponent(unsigned int a_count, bool a_normalized = false);
+	void addShortComponent(unsigned int a_count, bool a_normalized = false);
+	void addUShortComponent(unsigned int a_count, bool a_normalized = false);
 	void addFloatComponent(unsigned int a_count, bool a_normalized = false);
 	void addDoubleComponent(unsigned int a_count, bool a_normalized = false);
+	//adds four signed components packed into 10, 10, 10 and 2 bits of a single int (GL_INT_2_10_10_10_REV)
+	void addPackedComponent(bool a_normalized = true);
+
+	//makes the attributes advance per instance instead of per vertex
+	void setDivisor(unsigned int a_divisor);
 
 	//returns stride
 	unsigned int getStride()const;
 
-	//binds this layout
-	void bind();
+	//binds the vertex array object of this layout on a_vertexBuffer, starting a_offset bytes into it, and a_indexBuffer
+	//the object is built the first time the combination is bound, after that binding is a single call
+	void bind(GLuint a_vertexBuffer, GLuint a_indexBuffer = 0, size_t a_offset = 0);
+
+	//binds the vertex array object of this layout on a_vertexBuffer and a_indexBuffer, followed by the attributes of a_instanceLayout
+	//on a_instanceBuffer, starting a_instanceOffset bytes into it; the instance attributes take the locations after those of this layout
+	//a_instanceLayout is expected to be the same every time a combination of buffers is bound
+	void bindInstanced(GLuint a_vertexBuffer, GLuint a_indexBuffer, const VertexLayout& a_instanceLayout, GLuint a_instanceBuffer, size_t a_instanceOffset = 0);
+
+	//deletes the vertex array objects using a_vertexBuffer, as either buffer; call before deleting the buffer, since its name may be reused
+	void releaseVertexArrays(GLuint a_vertexBuffer);
+
+	//binds no vertex array object, so that binding an index buffer afterwards does not change the last bound one
+	static void unbind();
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <GLFW/glfw3.h>
 #include "Input.h"
 #include "Camera.h"
+#include "GLState.h"
 
 #include "Ghost.h"
 
@@ -23,8 +24,8 @@ int main()
     //set up input interface
     Input input(window);
 
-    glDisable(GL_CULL_FACE);
-    glEnable(GL_DEPTH_TEST);
+    GLState::setEnabled(GL_CULL_FACE, false);
+    GLState::setEnabled(GL_DEPTH_TEST, true);
     glDepthMask(GL_TRUE);
     Camera camera(90.f, windowSize, 0.1f, 100.f, { 20, 8, -15.0f }, { 0.f, 0.f, 1.f }, { 0.f, 1.f, 0.f });
 
@@ -53,6 +54,7 @@ int main()
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         ghost.draw(camera);
         glfwSwapBuffers(window);
+        GLState::endFrame();
 
     }
 